@@ -0,0 +1,461 @@
+// Microbenchmarks for every codec kernel.
+//
+// Usage: codec_bench [--filter=SUBSTR] [--min-size=N] [--max-size=N]
+//                    [--min-time=SECONDS] [--input=DUMP]
+//
+// Each case runs over a sweep of sizes (powers of ten from --min-size to
+// --max-size) and corpus presets: i.i.d. distributions plus Markov,
+// bursty and drifting sources. --input runs every case once on a
+// captured symbol dump instead (loadSymbolDump, format detected).
+// Throughput is reported per input symbol, and MB/s counts one byte per
+// raw symbol.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bitstream.hpp"
+#include "block_codec.hpp"
+#include "cabac.hpp"
+#include "cabac_slices.hpp"
+#include "codec_context.hpp"
+#include "corpus.hpp"
+#include "rans.hpp"
+#include "symbol_pack.hpp"
+#include "symbol_stats.hpp"
+#include "tans.hpp"
+
+namespace {
+
+// Corpus presets (corpus.hpp) swept by default.
+const std::vector<const char*>& distributions() {
+    static const std::vector<const char*> d = {
+        "p70", "uniform", "linear", "p97", "p999", "markov", "bursty", "drift",
+    };
+    return d;
+}
+
+std::vector<int> makeSource(size_t n, const char* corpus) {
+    const std::vector<uint8_t> s = generateCorpus(corpusPreset(corpus), n);
+    return std::vector<int>(s.begin(), s.end());
+}
+
+// A prepared kernel: run() is timed, items counts what one run processes.
+struct Kernel {
+    std::function<void()> run;
+    double items = 0;
+    const char* unit = "sym";
+};
+
+struct Case {
+    const char* name;
+    std::function<Kernel(const std::vector<int>&)> prepare;
+};
+
+// Keeps results alive so the optimizer cannot drop the work.
+volatile size_t sink = 0;
+
+template <class T>
+void consume(const T& v) { sink = sink + v.size(); }
+
+std::vector<Case> makeCases() {
+    std::vector<Case> c;
+    const auto n = [](const std::vector<int>& s) { return double(s.size()); };
+
+    c.push_back({"rans_encode", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() { consume(ransEncode(s)); }, n(s)};
+    }});
+    c.push_back({"rans_decode", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncode(s));
+        return Kernel{[st]() { consume(ransDecode(*st)); }, n(s)};
+    }});
+    // Same formats through reusable context buffers: no allocation per
+    // call once warm, which dominates at small message sizes.
+    c.push_back({"rans_encode_ctx", [n](const std::vector<int>& s) {
+        auto ctx = std::make_shared<EncoderContext>();
+        return Kernel{[&s, ctx]() { consume(ctx->ransEncode(s.data(), s.size())); }, n(s)};
+    }});
+    c.push_back({"rans_decode_ctx", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncode(s));
+        auto ctx = std::make_shared<DecoderContext>();
+        return Kernel{[st, ctx]() { consume(ctx->ransDecode(st->data(), st->size())); }, n(s)};
+    }});
+    c.push_back({"rans_small_encode_ctx", [n](const std::vector<int>& s) {
+        auto s8 = std::make_shared<std::vector<uint8_t>>(s.begin(), s.end());
+        auto ctx = std::make_shared<EncoderContext>();
+        return Kernel{[s8, ctx]() { consume(ctx->ransEncodeSmall(s8->data(), s8->size())); }, n(s)};
+    }});
+    c.push_back({"rans_small_decode_ctx", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncodeSmall(s));
+        auto ctx = std::make_shared<DecoderContext>();
+        return Kernel{[st, ctx]() { consume(ctx->ransDecodeSmall(st->data(), st->size())); }, n(s)};
+    }});
+    c.push_back({"rans_x4_encode", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() { consume(ransEncodeInterleaved(s, 4)); }, n(s)};
+    }});
+    c.push_back({"rans_x4_decode", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncodeInterleaved(s, 4));
+        return Kernel{[st]() { consume(ransDecodeInterleaved(*st)); }, n(s)};
+    }});
+    c.push_back({"rans_o1_encode", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() { consume(ransEncodeOrder(s, 1)); }, n(s)};
+    }});
+    c.push_back({"rans_o1_decode", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncodeOrder(s, 1));
+        return Kernel{[st]() { consume(ransDecodeOrder(*st)); }, n(s)};
+    }});
+    c.push_back({"rans_o2_decode", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncodeOrder(s, 2));
+        return Kernel{[st]() { consume(ransDecodeOrder(*st)); }, n(s)};
+    }});
+    c.push_back({"rans_x4_encode_u8", [n](const std::vector<int>& s) {
+        auto s8 = std::make_shared<std::vector<uint8_t>>(s.begin(), s.end());
+        return Kernel{[s8]() { consume(ransEncodeInterleaved(*s8, 4)); }, n(s)};
+    }});
+    c.push_back({"rans_x4_decode_u8", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncodeInterleaved(s, 4));
+        auto out = std::make_shared<std::vector<uint8_t>>(s.size());
+        return Kernel{[st, out]() {
+            sink = sink + ransDecodeInterleaved(st->data(), st->size(), out->data(), out->size());
+        }, n(s)};
+    }});
+    c.push_back({"rans_x4_decode_batched", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncodeInterleaved(s, 4));
+        return Kernel{[st]() {
+            sink = sink + ransDecodeInterleaved(st->data(), st->size(),
+                                                [](const uint8_t* p, size_t k) { sink = sink + p[k - 1]; });
+        }, n(s)};
+    }});
+    c.push_back({"rans_x4_encode_packed2", [n](const std::vector<int>& s) {
+        std::vector<uint8_t> s8(s.begin(), s.end());
+        auto p = std::make_shared<std::vector<uint8_t>>(packSymbols2(s8.data(), s8.size()));
+        const size_t count = s.size();
+        return Kernel{[p, count]() { consume(ransEncodePacked2(p->data(), count, 4)); }, n(s)};
+    }});
+    c.push_back({"rans_x4_decode_packed2", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncodeInterleaved(s, 4));
+        auto out = std::make_shared<std::vector<uint8_t>>(packedSize2(s.size()));
+        const size_t count = s.size();
+        return Kernel{[st, out, count]() {
+            sink = sink + ransDecodePacked2(st->data(), st->size(), out->data(), count);
+        }, n(s)};
+    }});
+    c.push_back({"rans64_encode", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() { consume(ransEncode64(s)); }, n(s)};
+    }});
+    c.push_back({"rans64_decode", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncode64(s));
+        return Kernel{[st]() { consume(ransDecode64(*st)); }, n(s)};
+    }});
+    c.push_back({"rans_adaptive_encode", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() { consume(ransEncodeAdaptive(s)); }, n(s)};
+    }});
+    c.push_back({"rans_adaptive_decode", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncodeAdaptive(s));
+        return Kernel{[st]() { consume(ransDecodeAdaptive(*st)); }, n(s)};
+    }});
+    c.push_back({"rans_simd32_encode", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() { consume(ransEncodeSimd(s, 32)); }, n(s)};
+    }});
+    c.push_back({"rans_simd32_decode_scalar", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncodeSimd(s, 32));
+        return Kernel{[st]() { consume(ransDecodeSimd(*st, RansDecodeKernel::Scalar)); }, n(s)};
+    }});
+    c.push_back({"rans_simd32_decode_auto", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncodeSimd(s, 32));
+        return Kernel{[st]() { consume(ransDecodeSimd(*st)); }, n(s)};
+    }});
+    c.push_back({"tans_encode", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() { consume(tansEncode(s)); }, n(s)};
+    }});
+    c.push_back({"tans_decode", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(tansEncode(s));
+        return Kernel{[st]() { consume(tansDecode(*st)); }, n(s)};
+    }});
+    c.push_back({"rans_simd32_decode_u8", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(ransEncodeSimd(s, 32));
+        auto out = std::make_shared<std::vector<uint8_t>>(s.size());
+        return Kernel{[st, out]() {
+            sink = sink + ransDecodeSimd(st->data(), st->size(), out->data(), out->size());
+        }, n(s)};
+    }});
+    c.push_back({"stats_histogram_u8", [n](const std::vector<int>& s) {
+        auto s8 = std::make_shared<std::vector<uint8_t>>(s.begin(), s.end());
+        return Kernel{[s8]() {
+            sink = sink + symbolHistogram(s8->data(), s8->size()).counts[1];
+        }, n(s)};
+    }});
+    // Sampled: the cost per block is flat, so items/s grows with size.
+    c.push_back({"stats_estimate_u8", [n](const std::vector<int>& s) {
+        auto s8 = std::make_shared<std::vector<uint8_t>>(s.begin(), s.end());
+        return Kernel{[s8]() {
+            sink = sink + static_cast<size_t>(estimateCodecs(s8->data(), s8->size()).best);
+        }, n(s)};
+    }});
+    c.push_back({"binarize", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() { consume(binarizeSequence(s, BinarizationType::Good)); }, n(s)};
+    }});
+    c.push_back({"binarize_packed", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() { consume(binarizeSequencePacked(s, BinarizationType::Good)); }, n(s)};
+    }});
+    c.push_back({"debinarize_packed", [n](const std::vector<int>& s) {
+        auto bins = std::make_shared<BinString>(binarizeSequencePacked(s, BinarizationType::Good));
+        auto out = std::make_shared<std::vector<uint8_t>>(s.size());
+        return Kernel{[bins, out]() {
+            sink = sink + debinarizeSequence(*bins, BinarizationType::Good, out->data(), out->size());
+        }, n(s)};
+    }});
+    c.push_back({"debinarize_expgolomb", [n](const std::vector<int>& s) {
+        auto eg = std::make_shared<Binarization>(Binarization::expGolomb(0, 4));
+        auto bins = std::make_shared<BinString>(eg->binarize(s));
+        auto out = std::make_shared<std::vector<int>>(s.size());
+        return Kernel{[eg, bins, out]() {
+            sink = sink + eg->debinarize(*bins, out->data(), out->size());
+        }, n(s)};
+    }});
+    c.push_back({"pack_bits", [](const std::vector<int>& s) {
+        auto bits = std::make_shared<std::vector<int>>(binarizeSequence(s, BinarizationType::Good));
+        return Kernel{[bits]() { consume(packBitsToBytes(*bits)); }, double(bits->size()), "bin"};
+    }});
+    c.push_back({"pack_bins", [](const std::vector<int>& s) {
+        auto bins = std::make_shared<BinString>(binarizeSequencePacked(s, BinarizationType::Good));
+        return Kernel{[bins]() { consume(packBitsToBytes(*bins)); }, double(bins->size()), "bin"};
+    }});
+    c.push_back({"bitwriter_codes", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() {
+            BitWriter bw;
+            for (int v : s) {
+                BinCode bc = binCode(v, BinarizationType::Good);
+                bw.writeBits(bc.code, bc.len);
+            }
+            consume(bw.flush());
+        }, n(s)};
+    }});
+    c.push_back({"bitreader_codes", [n](const std::vector<int>& s) {
+        auto bytes = std::make_shared<std::vector<uint8_t>>(
+            packBitsToBytes(binarizeSequencePacked(s, BinarizationType::Good)));
+        const size_t count = s.size();
+        return Kernel{[bytes, count]() {
+            BitReader br(*bytes);
+            size_t acc = 0;
+            for (size_t i = 0; i < count; ++i) {
+                // Truncated unary: ones up to the first zero.
+                uint64_t w = br.peekBits(4);
+                int len = 1;
+                while (len < 4 && (w >> (len - 1) & 1u)) ++len;
+                br.skipBits(len);
+                acc += static_cast<size_t>(len);
+            }
+            sink = sink + acc;
+        }, n(s)};
+    }});
+    c.push_back({"cabac_encode", [](const std::vector<int>& s) {
+        auto bins = std::make_shared<BinString>(binarizeSequencePacked(s, BinarizationType::Good));
+        return Kernel{[bins]() { consume(arithEncodeBits(*bins)); }, double(bins->size()), "bin"};
+    }});
+    c.push_back({"cabac_decode", [](const std::vector<int>& s) {
+        auto bins = binarizeSequencePacked(s, BinarizationType::Good);
+        auto st = std::make_shared<std::vector<uint8_t>>(arithEncodeBits(bins));
+        return Kernel{[st]() { consume(arithDecodeBins(*st)); }, double(bins.size()), "bin"};
+    }});
+    // Each symbol as two bypass bins, one call per bin or eight symbols
+    // per encodeBypassBits call.
+    c.push_back({"cabac_bypass_encode", [](const std::vector<int>& s) {
+        return Kernel{[&s]() {
+            CabacEncoder enc;
+            for (int v : s) {
+                enc.encodeBypass(v >> 1);
+                enc.encodeBypass(v & 1);
+            }
+            consume(enc.finish());
+        }, 2.0 * double(s.size()), "bin"};
+    }});
+    c.push_back({"cabac_bypass_encode_batched", [](const std::vector<int>& s) {
+        return Kernel{[&s]() {
+            CabacEncoder enc;
+            size_t i = 0;
+            for (; i + 8 <= s.size(); i += 8) {
+                uint32_t v = 0;
+                for (size_t k = 0; k < 8; ++k) v = (v << 2) | static_cast<uint32_t>(s[i + k]);
+                enc.encodeBypassBits(v, 16);
+            }
+            for (; i < s.size(); ++i) enc.encodeBypassBits(static_cast<uint32_t>(s[i]), 2);
+            consume(enc.finish());
+        }, 2.0 * double(s.size()), "bin"};
+    }});
+    c.push_back({"cabac_bypass_decode", [](const std::vector<int>& s) {
+        CabacEncoder enc;
+        for (int v : s) enc.encodeBypassBits(static_cast<uint32_t>(v), 2);
+        auto st = std::make_shared<std::vector<uint8_t>>(enc.finish());
+        const size_t count = s.size();
+        return Kernel{[st, count]() {
+            CabacDecoder dec(st->data(), st->size());
+            uint32_t acc = 0;
+            for (size_t i = 0; i < 2 * count; ++i) acc += static_cast<uint32_t>(dec.decodeBypass());
+            sink = sink + acc;
+        }, 2.0 * double(count), "bin"};
+    }});
+    c.push_back({"cabac_bypass_decode_batched", [](const std::vector<int>& s) {
+        CabacEncoder enc;
+        for (int v : s) enc.encodeBypassBits(static_cast<uint32_t>(v), 2);
+        auto st = std::make_shared<std::vector<uint8_t>>(enc.finish());
+        const size_t count = s.size();
+        return Kernel{[st, count]() {
+            CabacDecoder dec(st->data(), st->size());
+            uint32_t acc = 0;
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) acc += dec.decodeBypassBits(16);
+            for (; i < count; ++i) acc += dec.decodeBypassBits(2);
+            sink = sink + acc;
+        }, 2.0 * double(count), "bin"};
+    }});
+    c.push_back({"cabac_ctx_encode", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() { consume(cabacEncodeSymbols(s)); }, n(s)};
+    }});
+    c.push_back({"cabac_ctx_decode", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(cabacEncodeSymbols(s));
+        return Kernel{[st]() { consume(cabacDecodeSymbols(*st)); }, n(s)};
+    }});
+    c.push_back({"cabac_sliced_encode", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() { consume(cabacEncodeSlices(s)); }, n(s)};
+    }});
+    c.push_back({"cabac_sliced_decode", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(cabacEncodeSlices(s));
+        return Kernel{[st]() { consume(cabacDecodeSlices(*st)); }, n(s)};
+    }});
+    c.push_back({"blocks_rans_compress", [n](const std::vector<int>& s) {
+        return Kernel{[&s]() { consume(compressBlocks(s)); }, n(s)};
+    }});
+    c.push_back({"blocks_rans_decompress", [n](const std::vector<int>& s) {
+        auto st = std::make_shared<std::vector<uint8_t>>(compressBlocks(s));
+        return Kernel{[st]() { consume(decompressBlocks(*st)); }, n(s)};
+    }});
+    c.push_back({"blocks_tans_compress", [n](const std::vector<int>& s) {
+        BlockOptions opt;
+        opt.codec = BlockCodec::Tans;
+        return Kernel{[&s, opt]() { consume(compressBlocks(s, opt)); }, n(s)};
+    }});
+    c.push_back({"blocks_tans_decompress", [n](const std::vector<int>& s) {
+        BlockOptions opt;
+        opt.codec = BlockCodec::Tans;
+        auto st = std::make_shared<std::vector<uint8_t>>(compressBlocks(s, opt));
+        return Kernel{[st]() { consume(decompressBlocks(*st)); }, n(s)};
+    }});
+    return c;
+}
+
+// Run the kernel until minTime has elapsed (at least once); report the
+// mean time per iteration.
+double timeKernel(const Kernel& k, double minTime, size_t& iterations) {
+    using clock = std::chrono::steady_clock;
+    k.run(); // warm-up
+
+    iterations = 0;
+    size_t batch = 1;
+    double elapsed = 0.0;
+    while (elapsed < minTime) {
+        auto t0 = clock::now();
+        for (size_t i = 0; i < batch; ++i) k.run();
+        elapsed += std::chrono::duration<double>(clock::now() - t0).count();
+        iterations += batch;
+        batch *= 2;
+    }
+    return elapsed / double(iterations);
+}
+
+void runCases(const std::vector<Case>& cases, const std::vector<int>& source,
+              const std::string& label, const std::string& filter, double minTime)
+{
+    for (const Case& c : cases) {
+        std::string name = std::string(c.name) + "/" + label + "/" + std::to_string(source.size());
+        if (!filter.empty() && name.find(filter) == std::string::npos) continue;
+
+        Kernel k = c.prepare(source);
+        size_t iterations = 0;
+        const double sec = timeKernel(k, minTime, iterations);
+
+        char rate[32];
+        std::snprintf(rate, sizeof(rate), "%.1fM %s", k.items / sec / 1e6, k.unit);
+        std::printf("%-48s %12zu %14.0f %12s %10.1f\n",
+                    name.c_str(), iterations, sec * 1e9, rate,
+                    double(source.size()) / sec / 1e6);
+        std::fflush(stdout);
+    }
+}
+
+bool parseFlag(const char* arg, const char* name, std::string& value) {
+    const size_t len = std::strlen(name);
+    if (std::strncmp(arg, name, len) != 0 || arg[len] != '=') return false;
+    value = arg + len + 1;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string filter;
+    size_t minSize = 1000;
+    size_t maxSize = 1000000;
+    double minTime = 0.2;
+    std::string input;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string v;
+        if (parseFlag(argv[i], "--filter", v)) {
+            filter = v;
+        } else if (parseFlag(argv[i], "--min-size", v)) {
+            minSize = std::strtoull(v.c_str(), nullptr, 10);
+        } else if (parseFlag(argv[i], "--max-size", v)) {
+            maxSize = std::strtoull(v.c_str(), nullptr, 10);
+        } else if (parseFlag(argv[i], "--min-time", v)) {
+            minTime = std::strtod(v.c_str(), nullptr);
+        } else if (parseFlag(argv[i], "--input", v)) {
+            input = v;
+        } else {
+            std::fprintf(stderr,
+                "usage: %s [--filter=SUBSTR] [--min-size=N] [--max-size=N] [--min-time=S]"
+                " [--input=DUMP]\n",
+                argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<uint8_t> dump;
+    if (!input.empty()) {
+        try {
+            dump = loadSymbolDump(input);
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+            return 1;
+        }
+    }
+
+    const std::vector<Case> cases = makeCases();
+
+    std::printf("SIMD rANS kernel: %s\n", ransSimdAvailable() ? "avx2" : "scalar");
+    std::printf("%-48s %12s %14s %12s %10s\n",
+                "Benchmark", "Iterations", "ns/iter", "items/s", "MB/s");
+    std::printf("%s\n", std::string(100, '-').c_str());
+
+    if (!input.empty()) {
+        const size_t slash = input.find_last_of('/');
+        const std::string label = slash == std::string::npos ? input : input.substr(slash + 1);
+        runCases(cases, std::vector<int>(dump.begin(), dump.end()), label, filter, minTime);
+        return 0;
+    }
+
+    for (size_t size = std::max<size_t>(minSize, 1); size <= maxSize; size *= 10) {
+        for (const char* corpus : distributions()) {
+            runCases(cases, makeSource(size, corpus), corpus, filter, minTime);
+        }
+    }
+    return 0;
+}
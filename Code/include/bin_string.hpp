@@ -0,0 +1,68 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Bin string packed 64 bins per uint64_t word, bin i at bit (i % 64) of
+// word i / 64 (LSB-first, the same order BitWriter uses). Bits past
+// size() are always zero.
+class BinString {
+public:
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Pre-size the storage for nBins so append() never reallocates.
+    void reserve(size_t nBins) {
+        if (words_.size() < nBins / 64 + 2) words_.resize(nBins / 64 + 2, 0);
+    }
+
+    // Keeps the storage; only the words that held bins are zeroed.
+    void clear() {
+        const size_t used = std::min(words_.size(), wordCount() + 1);
+        std::fill(words_.begin(), words_.begin() + static_cast<std::ptrdiff_t>(used), uint64_t(0));
+        size_ = 0;
+    }
+
+    int operator[](size_t i) const {
+        return static_cast<int>((words_[i >> 6] >> (i & 63)) & 1u);
+    }
+
+    // Append len (<= 32) bins from code, bit 0 first; code must not have
+    // bits set at or above len.
+    void append(uint32_t code, int len) {
+        const size_t w   = size_ >> 6;
+        const unsigned b = static_cast<unsigned>(size_ & 63);
+        if (w + 2 > words_.size()) words_.resize(2 * words_.size() + 2, 0);
+        const uint64_t c = code;
+        words_[w] |= c << b;
+        if (b != 0) words_[w + 1] |= c >> (64 - b);
+        size_ += static_cast<size_t>(len);
+    }
+
+    void push(int bin) { append(bin != 0, 1); }
+
+    // Bins [pos, pos + k) as an LSB-first value, k <= 32; bins past
+    // size() read as zero.
+    uint32_t peek(size_t pos, int k) const {
+        const size_t w   = pos >> 6;
+        const unsigned b = static_cast<unsigned>(pos & 63);
+        if (w >= words_.size()) return 0;
+        uint64_t v = words_[w] >> b;
+        if (b != 0 && w + 1 < words_.size()) v |= words_[w + 1] << (64 - b);
+        return static_cast<uint32_t>(v & ((uint64_t(1) << k) - 1));
+    }
+
+    // Number of words holding bins: (size() + 63) / 64.
+    size_t wordCount() const { return (size_ + 63) / 64; }
+    const uint64_t* words() const { return words_.data(); }
+
+    // Number of 1 bins.
+    size_t countOnes() const;
+
+    bool operator==(const BinString& o) const;
+    bool operator!=(const BinString& o) const { return !(*this == o); }
+private:
+    std::vector<uint64_t> words_;
+    size_t size_ = 0;
+};
@@ -0,0 +1,149 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "bin_string.hpp"
+
+// Prefix-free binarizations: symbol -> (code, length) on the way in, and
+// a table indexed by the next few bins on the way out, so both
+// directions take one lookup per symbol. The built-in Good/Bad tables
+// are generated at compile time; other binarizations (fixed-length,
+// truncated unary, Exp-Golomb, truncated Rice, or any custom code) are
+// built at runtime and can be registered under an id.
+
+enum class BinarizationType {
+    Good,
+    Bad
+};
+
+// Codeword of one symbol: len bins, LSB-first in code.
+struct BinCode {
+    uint32_t code;
+    int      len;
+};
+
+constexpr int BIN_MAX_CODE_LEN = 32;
+constexpr int BIN_MAX_PEEK     = 12; // decode table of at most 4096 entries
+
+// Decode table entry for one window of peek bins: the symbol whose
+// codeword the window starts with, and its length; len == 0 when no
+// codeword of at most peek bins matches.
+struct BinDecodeEntry {
+    uint16_t symbol;
+    uint8_t  len;
+};
+
+// ------------------------------
+// Codeword builders
+// ------------------------------
+
+// Bins are appended LSB-first, so an MSB-first value is bit-reversed.
+constexpr uint32_t reverseBins(uint32_t v, int n) {
+    uint32_t r = 0;
+    for (int i = 0; i < n; ++i) r |= ((v >> i) & 1u) << (n - 1 - i);
+    return r;
+}
+
+// v ones then a terminating zero, which is dropped at v == cMax.
+constexpr BinCode truncatedUnaryCode(unsigned v, unsigned cMax) {
+    const int ones = static_cast<int>(v);
+    const uint32_t code = ones >= 32 ? ~0u : (1u << ones) - 1;
+    return BinCode{code, ones + (v < cMax ? 1 : 0)};
+}
+
+// v in bits bins, MSB first.
+constexpr BinCode fixedLengthCode(unsigned v, int bits) {
+    return BinCode{reverseBins(v, bits), bits};
+}
+
+// Fill table[0, 2^peek) for n codewords; returns false if two codewords
+// collide (the code is not prefix-free among the short ones).
+constexpr bool fillDecodeTable(const BinCode* codes, size_t n, int peek,
+                               BinDecodeEntry* table)
+{
+    const uint32_t size = 1u << peek;
+    for (uint32_t w = 0; w < size; ++w) table[w] = BinDecodeEntry{0, 0};
+    for (size_t s = 0; s < n; ++s) {
+        const int len = codes[s].len;
+        if (len > peek) continue;
+        // Every window whose low len bins equal the codeword.
+        for (uint32_t hi = 0; hi < (size >> len); ++hi) {
+            BinDecodeEntry& e = table[codes[s].code | (hi << len)];
+            if (e.len != 0) return false;
+            e = BinDecodeEntry{static_cast<uint16_t>(s), static_cast<uint8_t>(len)};
+        }
+    }
+    return true;
+}
+
+// Compile-time binarization with every codeword at most Peek bins.
+template <size_t Alph, int Peek>
+struct StaticBinarization {
+    std::array<BinCode, Alph> codes{};
+    std::array<BinDecodeEntry, (size_t(1) << Peek)> decode{};
+};
+
+// Good: symbol s is s ones and a zero. Bad: the same code on 3 - s.
+constexpr StaticBinarization<4, 4> makeUnaryBinarization(bool reversed) {
+    StaticBinarization<4, 4> b;
+    for (unsigned s = 0; s < 4; ++s) b.codes[s] = truncatedUnaryCode(reversed ? 3 - s : s, 4);
+    fillDecodeTable(b.codes.data(), b.codes.size(), 4, b.decode.data());
+    return b;
+}
+
+constexpr StaticBinarization<4, 4> GOOD_BINARIZATION = makeUnaryBinarization(false);
+constexpr StaticBinarization<4, 4> BAD_BINARIZATION  = makeUnaryBinarization(true);
+
+// ------------------------------
+// Runtime binarizations
+// ------------------------------
+
+class Binarization {
+public:
+    // Throws unless the codes are prefix-free, 1..BIN_MAX_CODE_LEN bins
+    // long, and at most 65536 of them.
+    explicit Binarization(std::vector<BinCode> codes);
+
+    static Binarization fixedLength(int bits);                       // 2^bits symbols
+    static Binarization truncatedUnary(unsigned cMax);               // 0..cMax
+    static Binarization expGolomb(int k, unsigned alphabetSize);     // EGk, ones prefix
+    static Binarization truncatedRice(int k, unsigned cMax);         // TU(v >> k) + k bins
+
+    size_t alphabetSize() const { return codes_.size(); }
+    int    maxLength() const { return maxLen_; }
+    BinCode code(unsigned symbol) const;
+    const std::vector<BinCode>& codes() const { return codes_; }
+
+    // The symbol whose codeword is exactly the len bins in code, or an
+    // entry with len 0 if none is: decoding one bin at a time, as the
+    // context-coded CABAC symbol coder does.
+    BinDecodeEntry match(uint32_t code, int len) const;
+
+    BinString binarize(const std::vector<int>& symbols) const;
+    BinString binarize(const std::vector<uint8_t>& symbols) const;
+
+    // Throws on a truncated or invalid codeword.
+    std::vector<int> debinarize(const BinString& bins) const;
+    size_t           debinarize(const BinString& bins, int* out, size_t capacity) const;
+private:
+    template <class Sym>
+    BinString binarizeImpl(const Sym* symbols, size_t n) const;
+    BinDecodeEntry decodeLong(const BinString& bins, size_t pos) const;
+
+    std::vector<BinCode> codes_;
+    std::vector<BinDecodeEntry> table_;
+    std::vector<uint64_t> longKeys_;  // codewords longer than peek_, sorted
+    std::vector<uint32_t> longCodes_; // their symbols
+    int peek_   = 0;
+    int maxLen_ = 0;
+};
+
+// Process-wide registry. Ids 0 and 1 are BinarizationType::Good and
+// ::Bad; registered binarizations get the following ids and are never
+// removed, so references stay valid. Thread-safe. cabacEncodeSymbols
+// accepts ids below 256 and records them in its stream header.
+int                 registerBinarization(Binarization b);
+const Binarization& binarization(int id);
+const Binarization& binarization(BinarizationType type);
@@ -1,25 +1,107 @@
 #pragma once
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+// LSB-first bit I/O through a 64-bit accumulator.
+// writeBits/readBits move up to 57 bits per call; whole bytes are
+// flushed/loaded with single 8-byte accesses.
 
 class BitWriter {
 public:
     void writeBit(bool bit);
-    void writeBits(uint32_t value, int nBits);
+    void writeBits(uint64_t value, int nBits); // 0 <= nBits <= 57
+
+    // Pad to a whole byte and move the bytes out; the writer is left
+    // empty. Hand the vector back through reset() to reuse its storage.
     std::vector<uint8_t> flush();
+
+    // Continue after the bytes already in buffer, reusing its capacity.
+    void reset(std::vector<uint8_t> buffer);
 private:
-    std::vector<uint8_t> buffer_;
-    uint8_t currentByte_ = 0;
-    int bitPos_ = 0; // 0..7
+    void grow();
+
+    std::vector<uint8_t> buffer_; // bytes_ valid bytes plus store slack
+    size_t bytes_ = 0;
+    uint64_t acc_ = 0;
+    int accBits_ = 0; // 0..7 between calls
 };
 
 class BitReader {
 public:
     explicit BitReader(const std::vector<uint8_t>& data);
+    BitReader(const uint8_t* data, size_t size); // reads in place, no copy
     bool readBit();
-    uint32_t readBits(int nBits);
+    uint64_t readBits(int nBits);  // 0 <= nBits <= 57, throws past the end
+
+    // Look at the next nBits (<= 56) without consuming them; bits past the
+    // end of the data read as zero. skipBits throws past the end.
+    uint64_t peekBits(int nBits);
+    void skipBits(int nBits);
+
+    // Bits not yet consumed.
+    size_t bitsLeft() const;
 private:
-    const std::vector<uint8_t>& data_;
-    size_t byteIndex_ = 0;
-    int bitPos_ = 0;
-};
\ No newline at end of file
+    void refill();
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t bytePos_ = 0;  // next byte to load into window_
+    uint64_t window_ = 0;
+    int windowBits_ = 0;
+};
+
+// ====================
+// Hot paths
+// ====================
+
+inline void BitWriter::writeBits(uint64_t value, int nBits) {
+    if (nBits <= 0) return;
+    acc_ |= (value & (~0ull >> (64 - nBits))) << accBits_;
+    accBits_ += nBits;
+
+    if (bytes_ + 8 > buffer_.size()) grow();
+
+    // Store the whole accumulator, keep only the complete bytes.
+    uint8_t* p = buffer_.data() + bytes_;
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<uint8_t>(acc_ >> (8 * i));
+    }
+    const int done = accBits_ & ~7;
+    bytes_   += static_cast<size_t>(done >> 3);
+    acc_      = (done == 64) ? 0 : (acc_ >> done);
+    accBits_ -= done;
+}
+
+inline void BitWriter::writeBit(bool bit) {
+    writeBits(bit ? 1u : 0u, 1);
+}
+
+inline uint64_t BitReader::peekBits(int nBits) {
+    if (windowBits_ < nBits) refill();
+    return window_ & ((1ull << nBits) - 1);
+}
+
+inline void BitReader::skipBits(int nBits) {
+    if (windowBits_ < nBits) refill();
+    if (windowBits_ < nBits) {
+        throw std::runtime_error("BitReader: out of data");
+    }
+    window_ >>= nBits;
+    windowBits_ -= nBits;
+}
+
+inline uint64_t BitReader::readBits(int nBits) {
+    if (nBits > 56) {
+        uint64_t lo = readBits(32);
+        return lo | (readBits(nBits - 32) << 32);
+    }
+    uint64_t v = peekBits(nBits);
+    skipBits(nBits);
+    return v;
+}
+
+inline bool BitReader::readBit() {
+    return readBits(1) != 0;
+}
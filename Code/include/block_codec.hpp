@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Block-parallel compression. The input is cut into fixed-size blocks
+// that are coded independently on a thread pool and concatenated in
+// block order, so the output does not depend on the thread count.
+//
+// Layout (all integers little-endian):
+//   header  "EECB" + version (u8) + codec (u8) + reserved (u16)
+//           + blockSize (u32) + N (u64)
+//   payload block payloads in block order
+//   index   per block: offset (u64) + compressed size (u32)
+//           + raw size (u32) + XXH64 of the payload (u64)
+//   footer  index offset (u64) + nBlocks (u32) + XXH64 of the index (u64)
+//           + "EECX"
+// The trailing index lets a reader seek to, skip or verify any block
+// without decoding the others; a truncated stream loses its footer and
+// is rejected up front.
+
+constexpr uint8_t BLOCK_CONTAINER_VERSION = 2;
+
+enum class BlockCodec : uint8_t {
+    Rans  = 0, // ransEncodeSimd, 32 lanes
+    Cabac = 1, // cabacEncodeSymbols, Good binarization, BinIndex contexts
+    Tans  = 2, // tansEncode
+    Raw   = 3  // 2-bit packed symbols (symbol_pack.hpp)
+};
+
+struct BlockOptions {
+    BlockCodec codec  = BlockCodec::Rans;
+    size_t blockSize  = size_t(1) << 20;
+    unsigned threads  = 0; // 0 = all hardware threads
+};
+
+std::vector<uint8_t> compressBlocks(const std::vector<int>& symbols,
+                                    const BlockOptions& opt = BlockOptions());
+std::vector<int>     decompressBlocks(const std::vector<uint8_t>& stream,
+                                      unsigned threads = 0);
+
+// uint8_t symbols, same container; the pointer form reads the input in
+// place (e.g. from a MappedFile).
+std::vector<uint8_t> compressBlocks(const std::vector<uint8_t>& symbols,
+                                    const BlockOptions& opt = BlockOptions());
+std::vector<uint8_t> compressBlocks(const uint8_t* symbols, size_t n,
+                                    const BlockOptions& opt = BlockOptions());
+
+// Zero-copy decode: blocks are read in place and written straight into
+// out[0, capacity); throws if the stream holds more than capacity symbols.
+size_t decompressedSize(const uint8_t* stream, size_t size);
+size_t decompressBlocks(const uint8_t* stream, size_t size, int* out,
+                        size_t capacity, unsigned threads = 0);
+size_t decompressBlocks(const uint8_t* stream, size_t size, uint8_t* out,
+                        size_t capacity, unsigned threads = 0);
+
+// Memory-maps a compressed file and decodes it in place.
+std::vector<int> decompressFile(const std::string& path, unsigned threads = 0);
+
+// Container inspection. blockIndex validates header, footer and index
+// (not payloads) and throws on failure; verifyBlocks also checks every
+// payload checksum and returns false instead of throwing.
+struct BlockInfo {
+    uint64_t offset = 0;         // payload start in the stream
+    uint32_t compressedSize = 0;
+    uint32_t rawSize = 0;        // symbols
+    uint64_t checksum = 0;       // xxhash64 of the payload
+    uint64_t rawOffset = 0;      // first symbol of the block
+};
+
+BlockCodec             blockCodec(const uint8_t* stream, size_t size);
+std::vector<BlockInfo> blockIndex(const uint8_t* stream, size_t size);
+bool                   verifyBlocks(const uint8_t* stream, size_t size);
+
+// Random access through the block index.
+size_t           blockCount(const std::vector<uint8_t>& stream);
+std::vector<int> decompressBlock(const std::vector<uint8_t>& stream,
+                                 size_t index);
@@ -0,0 +1,96 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+// Little-endian helpers shared by the stream formats.
+
+inline void writeU32LE(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(static_cast<uint8_t>( v        & 0xFFu));
+    out.push_back(static_cast<uint8_t>((v >> 8)  & 0xFFu));
+    out.push_back(static_cast<uint8_t>((v >> 16) & 0xFFu));
+    out.push_back(static_cast<uint8_t>((v >> 24) & 0xFFu));
+}
+
+inline void writeU64LE(std::vector<uint8_t>& out, uint64_t v) {
+    writeU32LE(out, static_cast<uint32_t>(v));
+    writeU32LE(out, static_cast<uint32_t>(v >> 32));
+}
+
+inline void writeU16LE(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(static_cast<uint8_t>( v        & 0xFFu));
+    out.push_back(static_cast<uint8_t>((v >> 8)  & 0xFFu));
+}
+
+// Readers take either a vector or a (pointer, size) view; both advance
+// offset and throw on truncated input.
+
+inline uint32_t readU32LE(const uint8_t* in, size_t size, size_t& offset) {
+    if (offset + 4 > size) {
+        throw std::runtime_error("readU32LE: truncated input");
+    }
+    uint32_t v = 0;
+    v |= static_cast<uint32_t>(in[offset + 0]) << 0;
+    v |= static_cast<uint32_t>(in[offset + 1]) << 8;
+    v |= static_cast<uint32_t>(in[offset + 2]) << 16;
+    v |= static_cast<uint32_t>(in[offset + 3]) << 24;
+    offset += 4;
+    return v;
+}
+
+inline uint16_t readU16LE(const uint8_t* in, size_t size, size_t& offset) {
+    if (offset + 2 > size) {
+        throw std::runtime_error("readU16LE: truncated input");
+    }
+    uint16_t v = 0;
+    v |= static_cast<uint16_t>(in[offset + 0]) << 0;
+    v |= static_cast<uint16_t>(in[offset + 1]) << 8;
+    offset += 2;
+    return v;
+}
+
+inline uint64_t readU64LE(const uint8_t* in, size_t size, size_t& offset) {
+    uint64_t lo = readU32LE(in, size, offset);
+    uint64_t hi = readU32LE(in, size, offset);
+    return lo | (hi << 32);
+}
+
+inline uint32_t readU32LE(const std::vector<uint8_t>& in, size_t& offset) {
+    return readU32LE(in.data(), in.size(), offset);
+}
+
+inline uint16_t readU16LE(const std::vector<uint8_t>& in, size_t& offset) {
+    return readU16LE(in.data(), in.size(), offset);
+}
+
+inline uint64_t readU64LE(const std::vector<uint8_t>& in, size_t& offset) {
+    return readU64LE(in.data(), in.size(), offset);
+}
+
+// LEB128: 7 bits per byte, low group first, high bit set on all but the
+// last byte.
+inline void writeVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80u) {
+        out.push_back(static_cast<uint8_t>(v | 0x80u));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+inline uint64_t readVarint(const uint8_t* in, size_t size, size_t& offset) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (offset >= size) {
+            throw std::runtime_error("readVarint: truncated input");
+        }
+        const uint8_t b = in[offset++];
+        v |= static_cast<uint64_t>(b & 0x7Fu) << shift;
+        if ((b & 0x80u) == 0) return v;
+    }
+    throw std::runtime_error("readVarint: value too long");
+}
+
+inline uint64_t readVarint(const std::vector<uint8_t>& in, size_t& offset) {
+    return readVarint(in.data(), in.size(), offset);
+}
@@ -1,11 +1,11 @@
 #pragma once
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 
-enum class BinarizationType {
-    Good,
-    Bad
-};
+#include "bin_string.hpp"
+#include "binarization.hpp"
+#include "codec_trace.hpp"
 
 // Binarize a single symbol (0..3).
 std::vector<int> binarizeSymbol(int symbol, BinarizationType type);
@@ -17,6 +17,187 @@ std::vector<int> binarizeSequence(const std::vector<int>& symbols,
 // Pack bits (0/1) into bytes.
 std::vector<unsigned char> packBitsToBytes(const std::vector<int>& bits);
 
-// Toy binary arithmetic coder on bits.
+BinCode binCode(int symbol, BinarizationType type);
+
+// Binarize straight into a packed bin string, one (code, length) lookup
+// per symbol and no per-symbol allocation.
+BinString binarizeSequencePacked(const std::vector<int>& symbols,
+                                 BinarizationType type);
+BinString binarizeSequencePacked(const std::vector<uint8_t>& symbols,
+                                 BinarizationType type);
+
+// Same, replacing the contents of out; a reused BinString keeps its
+// storage, so repeated calls on similar sizes do not allocate.
+void binarizeSequencePacked(const int* symbols, size_t n, BinarizationType type,
+                            BinString& out);
+void binarizeSequencePacked(const uint8_t* symbols, size_t n, BinarizationType type,
+                            BinString& out);
+
+std::vector<unsigned char> packBitsToBytes(const BinString& bins);
+
+// Inverse of binarizeSequencePacked; throws on a truncated codeword.
+std::vector<int> debinarizeSequence(const BinString& bins,
+                                    BinarizationType type);
+
+// Same, into out[0, capacity); returns the symbol count.
+size_t debinarizeSequence(const BinString& bins, BinarizationType type,
+                          uint8_t* out, size_t capacity);
+
+// ============================
+// CABAC arithmetic engine
+// ============================
+
+// Adaptive probability model for one binary context (H.264 style).
+// pStateIdx and valMPS share one byte so that a single cabacTransTab
+// lookup yields both the LPS range and the next context.
+struct CabacContext {
+    uint8_t packed = 0; // pStateIdx (0..62) << 1 | valMPS
+
+    int state() const { return packed >> 1; }
+    int mps() const { return packed & 1; }
+};
+
+// Table-driven binary arithmetic encoder with a 9-bit range register.
+// Bytes are emitted MSB-first with deferred carry propagation.
+class CabacEncoder {
+public:
+    void encodeDecision(CabacContext& ctx, int bin);
+    void encodeBypass(int bin);
+
+    // n (0..32) equiprobable bins, MSB of value first; identical output
+    // to n encodeBypass calls but shifts low by up to 8 bins at once.
+    void encodeBypassBits(uint32_t value, int n);
+
+    // Terminate the arithmetic codeword and return the coded bytes.
+    std::vector<uint8_t> finish();
+
+    // Start a new codeword after the bytes already in buffer (a header,
+    // say), which are left untouched; its capacity is reused, so a
+    // vector handed back from finish() makes the next call allocation-free.
+    void reset(std::vector<uint8_t> buffer);
+private:
+    void putByte();
+
+    std::vector<uint8_t> out_;
+    size_t start_    = 0;  // first byte of the codeword in out_
+    uint32_t low_   = 0;
+    uint32_t range_ = 510;
+    int queue_       = -9; // pending bits in low_ before the next byte
+    int outstanding_ = 0;  // 0xFF bytes waiting on a possible carry
+    CODEC_TRACE_ONLY(CodecTally tally_;)
+};
+
+// Decoder matching CabacEncoder. Reads past the end of the data as zeros,
+// so the caller must know how many bins to decode.
+class CabacDecoder {
+public:
+    CabacDecoder(const uint8_t* data, size_t size);
+    int decodeDecision(CabacContext& ctx);
+    int decodeBypass();
+
+    // Inverse of encodeBypassBits: up to 16 bins per division.
+    uint32_t decodeBypassBits(int n);
+private:
+    void refill();
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+    uint64_t value_ = 0;  // offset register followed by avail_ lookahead bits
+    int avail_      = -9;
+    uint32_t range_ = 510;
+    CODEC_TRACE_ONLY(CodecTally tally_;)
+};
+
+// Upper bound on the bins a codeword of `bytes` bytes can hold. The
+// cheapest bin is an MPS at state 62, log2(319 / 313) ~ 0.027 bits, so
+// fewer than 292 fit in a byte; finish() drops at most one byte. The
+// decoders reject larger counts before allocating for them.
+constexpr uint64_t CABAC_MAX_BINS_PER_BYTE = 320;
+
+constexpr bool cabacBinCountFits(uint64_t nBins, size_t bytes) {
+    return nBins <= CABAC_MAX_BINS_PER_BYTE * (uint64_t(bytes) + 1);
+}
+
+// Adaptive CABAC on a bin string (single context).
+// Stream layout: nBins (u32 LE) + arithmetic codeword.
 std::vector<uint8_t> arithEncodeBits(const std::vector<int>& bits);
-std::vector<int>     arithDecodeBits(const std::vector<uint8_t>& stream);
\ No newline at end of file
+std::vector<int>     arithDecodeBits(const std::vector<uint8_t>& stream);
+
+std::vector<uint8_t> arithEncodeBits(const BinString& bins);
+BinString            arithDecodeBins(const std::vector<uint8_t>& stream);
+BinString            arithDecodeBins(const uint8_t* stream, size_t size); // in place
+void                 arithDecodeBins(const uint8_t* stream, size_t size, BinString& out);
+// ============================
+// Context-modeled symbol coder
+// ============================
+
+// How each bin of a symbol's codeword picks its context. Bin statistics
+// of the unary binarizations depend mostly on bin position, and on
+// correlated data also on the previous symbol.
+enum class CabacContextMode : uint8_t {
+    Single             = 0, // one context for every bin
+    BinIndex           = 1, // one context per bin position (4)
+    BinIndexPrevSymbol = 2  // per bin position and previous symbol (16)
+};
+
+constexpr int CABAC_MAX_CONTEXTS = 16;
+
+// Number of contexts a mode uses, and the context of bin `binIdx` given
+// the previous symbol (0 before the first symbol).
+constexpr int cabacContextCount(CabacContextMode mode) {
+    return mode == CabacContextMode::Single ? 1
+         : mode == CabacContextMode::BinIndex ? 4 : 16;
+}
+
+constexpr int cabacContextIndex(CabacContextMode mode, int binIdx, int prevSymbol) {
+    return mode == CabacContextMode::Single ? 0
+         : mode == CabacContextMode::BinIndex ? binIdx : 4 * prevSymbol + binIdx;
+}
+
+// Binarize and code symbols in one pass, one adaptive CabacContext per
+// context slot. Stream layout: N (u32 LE) + binarization (u8)
+// + context mode (u8) + arithmetic codeword.
+std::vector<uint8_t> cabacEncodeSymbols(const std::vector<int>& symbols,
+                                        BinarizationType type = BinarizationType::Good,
+                                        CabacContextMode mode = CabacContextMode::BinIndex);
+std::vector<uint8_t> cabacEncodeSymbols(const std::vector<uint8_t>& symbols,
+                                        BinarizationType type = BinarizationType::Good,
+                                        CabacContextMode mode = CabacContextMode::BinIndex);
+std::vector<int>     cabacDecodeSymbols(const std::vector<uint8_t>& stream);
+
+// Same format, replacing the contents of out and reusing its capacity.
+void cabacEncodeSymbols(const int* symbols, size_t n, BinarizationType type,
+                        CabacContextMode mode, std::vector<uint8_t>& out);
+void cabacEncodeSymbols(const uint8_t* symbols, size_t n, BinarizationType type,
+                        CabacContextMode mode, std::vector<uint8_t>& out);
+
+// Same format with any binarization: binarizationId comes from
+// registerBinarization (0 and 1 are Good and Bad) and goes in the
+// binarization byte, so it must be below 256 and the decoding process
+// must have registered the same code under it. Bins past the fourth
+// share the last position context, and symbols above 3 the last
+// previous-symbol context.
+void cabacEncodeSymbols(const int* symbols, size_t n, int binarizationId,
+                        CabacContextMode mode, std::vector<uint8_t>& out);
+void cabacEncodeSymbols(const uint8_t* symbols, size_t n, int binarizationId,
+                        CabacContextMode mode, std::vector<uint8_t>& out);
+
+// Zero-copy decode into out[0, capacity); returns the symbol count.
+// Throws on a binarization id that is neither built in nor registered.
+size_t cabacDecodedSize(const uint8_t* stream, size_t size);
+size_t cabacDecodeSymbols(const uint8_t* stream, size_t size,
+                          int* out, size_t capacity);
+size_t cabacDecodeSymbols(const uint8_t* stream, size_t size,
+                          uint8_t* out, size_t capacity);
+
+// Bare codeword of n symbols, contexts starting from their reset state:
+// the unit that sliced streams (cabac_slices.hpp) are built from.
+std::vector<uint8_t> cabacEncodeRun(const int* symbols, size_t n,
+                                    BinarizationType type, CabacContextMode mode);
+std::vector<uint8_t> cabacEncodeRun(const uint8_t* symbols, size_t n,
+                                    BinarizationType type, CabacContextMode mode);
+void cabacDecodeRun(const uint8_t* data, size_t size, BinarizationType type,
+                    CabacContextMode mode, int* out, size_t n);
+void cabacDecodeRun(const uint8_t* data, size_t size, BinarizationType type,
+                    CabacContextMode mode, uint8_t* out, size_t n);
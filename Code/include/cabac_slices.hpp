@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "cabac.hpp"
+
+// Sliced CABAC: the input is cut into slices of sliceSize symbols, and
+// each slice is coded as its own substream with contexts reset and the
+// coder flushed at the boundary (as with HEVC tiles). Substreams are
+// independent, so both directions run them on the shared thread pool
+// (thread_pool.hpp); the output does not depend on the thread count.
+//
+// Layout: N (u32) + binarization (u8) + context mode (u8)
+//         + sliceSize (u32) + nSlices (u32)
+//         + nSlices substream end offsets (u64) + substreams.
+
+struct CabacSliceOptions {
+    BinarizationType type = BinarizationType::Good;
+    CabacContextMode mode = CabacContextMode::BinIndex;
+    size_t sliceSize      = size_t(1) << 16;
+    unsigned threads      = 0; // 0 = all hardware threads
+};
+
+std::vector<uint8_t> cabacEncodeSlices(const std::vector<int>& symbols,
+                                       const CabacSliceOptions& opt = CabacSliceOptions());
+std::vector<uint8_t> cabacEncodeSlices(const std::vector<uint8_t>& symbols,
+                                       const CabacSliceOptions& opt = CabacSliceOptions());
+std::vector<int>     cabacDecodeSlices(const std::vector<uint8_t>& stream,
+                                       unsigned threads = 0);
+
+// Zero-copy decode into out[0, capacity); returns the symbol count.
+size_t cabacSlicedSize(const uint8_t* stream, size_t size);
+size_t cabacDecodeSlices(const uint8_t* stream, size_t size, int* out,
+                         size_t capacity, unsigned threads = 0);
+size_t cabacDecodeSlices(const uint8_t* stream, size_t size, uint8_t* out,
+                         size_t capacity, unsigned threads = 0);
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <cstdint>
 
 // From ITU-T H.264 / AVC CABAC tables,
@@ -6,5 +7,19 @@
 // These tables are public domain.
 
 extern const uint8_t cabacRangeTabLPS[64][4];
-extern const uint8_t cabacTransIdxLPS[64];
-extern const uint8_t cabacTransIdxMPS[64];
\ No newline at end of file
+extern const std::array<uint8_t, 64> cabacTransIdxLPS;
+extern const std::array<uint8_t, 64> cabacTransIdxMPS;
+extern const uint8_t cabacRenormShift[64];
+
+// transIdxLPS is the normative table and transIdxMPS (s + 1 up to 62)
+// is generated. cabacTransTab fuses them with the range table: one entry
+// per context, indexed by pStateIdx << 1 | valMPS, holds the LPS range
+// for each range quarter and the successor context for either bin
+// value. All 128 entries are checked against the tables at compile time.
+struct CabacTransition {
+    uint8_t rangeLPS[4];
+    uint8_t next[2];
+    uint8_t pad[2];
+};
+
+extern const std::array<CabacTransition, 128> cabacTransTab;
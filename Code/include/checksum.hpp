@@ -0,0 +1,7 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// XXH64: 64-bit non-cryptographic hash, several GB/s per core. Used to
+// verify container blocks without decoding them.
+uint64_t xxhash64(const uint8_t* data, size_t size, uint64_t seed = 0);
@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "cabac.hpp"
+#include "rans.hpp"
+
+// Reusable scratch for the one-shot coders. Each call writes into a
+// buffer owned by the context and returns a reference to it. Buffers
+// only grow, so once a context has seen a message of a given size,
+// further calls on messages up to that size do not touch the allocator.
+// A returned reference stays valid until the next call on the same
+// context. Not thread-safe: keep one context per thread.
+
+class EncoderContext {
+public:
+    // ransEncode / ransEncodeInterleaved formats.
+    const std::vector<uint8_t>& ransEncode(const uint8_t* symbols, size_t n);
+    const std::vector<uint8_t>& ransEncode(const int* symbols, size_t n);
+    const std::vector<uint8_t>& ransEncodeInterleaved(const uint8_t* symbols, size_t n,
+                                                      int lanes);
+    const std::vector<uint8_t>& ransEncodeInterleaved(const int* symbols, size_t n,
+                                                      int lanes);
+
+    // ransEncodeSmall format.
+    const std::vector<uint8_t>& ransEncodeSmall(const uint8_t* symbols, size_t n,
+                                                int table = RANS_SMALL_AUTO);
+
+    // cabacEncodeSymbols format.
+    const std::vector<uint8_t>& cabacEncodeSymbols(
+        const uint8_t* symbols, size_t n,
+        BinarizationType type = BinarizationType::Good,
+        CabacContextMode mode = CabacContextMode::BinIndex);
+
+    // binarizeSequencePacked; independent of the stream buffer.
+    const BinString& binarize(const uint8_t* symbols, size_t n, BinarizationType type);
+
+    // Drop the buffers, returning their memory.
+    void release();
+private:
+    std::vector<uint8_t> stream_;
+    BinString bins_;
+};
+
+// Decoded symbols come back as uint8_t; int callers keep their own
+// vector and use the pointer forms of the decoders.
+class DecoderContext {
+public:
+    const std::vector<uint8_t>& ransDecode(const uint8_t* stream, size_t size);
+    const std::vector<uint8_t>& ransDecodeInterleaved(const uint8_t* stream, size_t size);
+    const std::vector<uint8_t>& ransDecodeSmall(const uint8_t* stream, size_t size);
+    const std::vector<uint8_t>& cabacDecodeSymbols(const uint8_t* stream, size_t size);
+
+    // arithDecodeBins; independent of the symbol buffer.
+    const BinString& arithDecodeBins(const uint8_t* stream, size_t size);
+
+    void release();
+private:
+    std::vector<uint8_t> symbols_;
+    BinString bins_;
+};
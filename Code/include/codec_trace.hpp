@@ -0,0 +1,146 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Hot-path instrumentation, compiled in only with CODEC_INSTRUMENT
+// defined (CMake option CODE_INSTRUMENT). The coders then bump
+// per-thread counters and time their pipeline stages; without it the
+// CODEC_COUNT / CODEC_STAGE / CODEC_TRACE_ONLY macros expand to nothing,
+// nothing is stored, and snapshots read as all zero. rANS counters cover
+// the scalar engine (rans_codec.hpp) and are added once per call.
+//
+// Counters are per-thread relaxed atomics written with a plain
+// load/store (no locked read-modify-write), so worker threads do not
+// contend; codecTraceSnapshot sums every live thread plus the totals of
+// threads that have exited.
+
+enum class CodecCounter : int {
+    RansEncodeSymbols,  // scalar rANS engine (rans_codec.hpp)
+    RansDecodeSymbols,
+    RansWordsOut,       // renormalization steps while encoding
+    RansWordsIn,        // renormalization steps while decoding
+    RansBytesOut,
+    CabacContextBins,   // context-coded bins, encode + decode
+    CabacBypassBins,
+    CabacMps,
+    CabacLps,
+    CabacBytesOut,
+    Count
+};
+
+enum class CodecStage : int {
+    Histogram,
+    Normalize,
+    Encode,
+    Decode,
+    Binarize,
+    Pack,
+    Count
+};
+
+constexpr size_t CODEC_COUNTER_COUNT  = static_cast<size_t>(CodecCounter::Count);
+constexpr size_t CODEC_STAGE_COUNT    = static_cast<size_t>(CodecStage::Count);
+constexpr size_t CODEC_TRACE_CONTEXTS = 16; // CABAC context slots counted per index
+
+struct CodecStageTime {
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;
+};
+
+struct CodecTrace {
+    std::array<uint64_t, CODEC_COUNTER_COUNT> counters{};
+    std::array<uint64_t, CODEC_TRACE_CONTEXTS> contextBins{}; // by context index
+    std::array<CodecStageTime, CODEC_STAGE_COUNT> stages{};
+
+    uint64_t counter(CodecCounter c) const { return counters[static_cast<size_t>(c)]; }
+    const CodecStageTime& stage(CodecStage s) const { return stages[static_cast<size_t>(s)]; }
+};
+
+constexpr bool codecInstrumentationEnabled() {
+#if defined(CODEC_INSTRUMENT)
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char* codecCounterName(CodecCounter c);
+const char* codecStageName(CodecStage s);
+
+// Totals since the last reset, over all threads.
+CodecTrace  codecTraceSnapshot();
+void        codecTraceReset();
+std::string codecTraceJson(const CodecTrace& t);
+
+// Optional tracing hook, called on entry to and exit from every timed
+// stage (begin == true on entry) that runs on the thread which installed
+// it; nullptr removes it. Only reached with CODEC_INSTRUMENT.
+using CodecTraceHook = void (*)(CodecStage stage, bool begin, void* user);
+void codecSetTraceHook(CodecTraceHook hook, void* user);
+
+// ------------------------------
+// Recording (internal)
+// ------------------------------
+
+struct CodecTraceBlock {
+    std::array<std::atomic<uint64_t>, CODEC_COUNTER_COUNT> counters{};
+    std::array<std::atomic<uint64_t>, CODEC_TRACE_CONTEXTS> contextBins{};
+    std::array<std::atomic<uint64_t>, CODEC_STAGE_COUNT> stageCalls{};
+    std::array<std::atomic<uint64_t>, CODEC_STAGE_COUNT> stageNs{};
+
+    CodecTraceBlock();
+    ~CodecTraceBlock();
+};
+
+extern thread_local CodecTraceBlock codecTraceTls;
+
+// Single writer per block, so load + store is enough.
+inline void codecTraceAdd(std::atomic<uint64_t>& c, uint64_t n) {
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+class CodecStageTimer {
+public:
+    explicit CodecStageTimer(CodecStage s);
+    ~CodecStageTimer();
+    CodecStageTimer(const CodecStageTimer&) = delete;
+    CodecStageTimer& operator=(const CodecStageTimer&) = delete;
+private:
+    CodecStage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Per-call tally for counters bumped once per bin: the coder keeps
+// plain locals and adds them to the thread's totals when it goes out of
+// scope, so the hot loop never touches thread-local storage.
+struct CodecTally {
+    uint64_t contextBins = 0;
+    uint64_t bypassBins  = 0;
+    uint64_t lps         = 0;
+    std::array<uint64_t, CODEC_TRACE_CONTEXTS> byContext{};
+
+    CodecTally() = default;
+    CodecTally(const CodecTally&) = delete;
+    CodecTally& operator=(const CodecTally&) = delete;
+    ~CodecTally();
+};
+
+#define CODEC_TRACE_CAT2(a, b) a##b
+#define CODEC_TRACE_CAT(a, b)  CODEC_TRACE_CAT2(a, b)
+
+#if defined(CODEC_INSTRUMENT)
+    #define CODEC_COUNT(counter, n) \
+        codecTraceAdd(codecTraceTls.counters[static_cast<size_t>(CodecCounter::counter)], \
+                      static_cast<uint64_t>(n))
+    #define CODEC_STAGE(stage) \
+        CodecStageTimer CODEC_TRACE_CAT(codecStageTimer_, __LINE__)(CodecStage::stage)
+    #define CODEC_TRACE_ONLY(...) __VA_ARGS__
+#else
+    #define CODEC_COUNT(counter, n)       ((void)0)
+    #define CODEC_STAGE(stage)            ((void)0)
+    #define CODEC_TRACE_ONLY(...)
+#endif
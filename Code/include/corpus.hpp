@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// Benchmark corpora for the 4-symbol alphabet: synthetic sources with
+// memory (Markov, bursty, drifting) next to the i.i.d. ones, and loaders
+// for captured symbol dumps.
+//
+// Synthetic output is cut into CORPUS_CHUNK-symbol chunks, each drawn
+// from its own generator seeded from (seed, chunk index). The result
+// depends only on the spec and the length, never on the thread count,
+// so chunks can be filled in any order on a pool and sizes are bounded
+// only by memory. Sources with state restart each chunk from their
+// stationary distribution, which leaves the statistics unchanged.
+
+constexpr size_t CORPUS_CHUNK = size_t(1) << 20;
+
+// xoshiro256** seeded through splitmix64: 64 random bits in a few
+// cycles, with no state shared between chunks.
+class CorpusRng {
+public:
+    explicit CorpusRng(uint64_t seed) {
+        for (auto& w : s_) {
+            seed += 0x9E3779B97F4A7C15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            w = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        const uint64_t r = rotl(s_[1] * 5, 7) * 9;
+        const uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return r;
+    }
+
+    // Uniform in (0, 1].
+    double unit() { return double((next() >> 11) + 1) * 0x1.0p-53; }
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    std::array<uint64_t, 4> s_;
+};
+
+enum class CorpusKind : uint8_t {
+    Iid,    // every symbol from weights
+    Markov, // symbol from transition[previous symbol]
+    Bursty, // runs from weights and from alt, of geometric length with mean period
+    Drift,  // weights blend to alt and back over period symbols
+};
+
+// Weights are relative and need not sum to anything; a zero weight
+// never occurs.
+struct CorpusSpec {
+    CorpusKind kind = CorpusKind::Iid;
+    std::array<double, 4> weights{70, 10, 10, 10};
+    std::array<double, 4> alt{25, 25, 25, 25};
+    std::array<std::array<double, 4>, 4> transition{};
+    double period = 4096;
+    uint64_t seed = 12345;
+};
+
+// Named specs: p70, uniform, near_uniform, linear, p97, p999, p9999
+// (i.i.d.), markov (order-1 correlated), bursty (p97 with uniform
+// bursts), drift (p97 to uniform and back every 2^20 symbols). Throws
+// on an unknown name.
+CorpusSpec corpusPreset(const std::string& name);
+const std::vector<const char*>& corpusPresetNames();
+
+// Throw on negative or all-zero weights and on a period below 1.
+void generateCorpus(const CorpusSpec& spec, uint8_t* out, size_t n);
+void generateCorpus(const CorpusSpec& spec, uint8_t* out, size_t n, ThreadPool& pool);
+std::vector<uint8_t> generateCorpus(const CorpusSpec& spec, size_t n);
+
+// ------------------------------
+// Captured dumps
+// ------------------------------
+
+enum class DumpFormat : uint8_t {
+    Auto,    // Bytes when every byte is 0..3, else Text
+    Bytes,   // one symbol per byte, as codec_cli reads and writes
+    Text,    // digits 0..3; whitespace and commas are skipped
+    Packed2, // four symbols per byte (symbol_pack.hpp), 4 * size symbols
+};
+
+// The file is mapped and checked in one pass; throws on anything that
+// is not a symbol in the chosen format.
+std::vector<uint8_t> loadSymbolDump(const std::string& path,
+                                    DumpFormat format = DumpFormat::Auto);
+void saveSymbolDump(const std::string& path, const uint8_t* symbols, size_t n,
+                    DumpFormat format = DumpFormat::Bytes);
@@ -1,9 +1,157 @@
 #pragma once
+#include <array>
 #include <vector>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 
 // rANS encoder/decoder for a 4-symbol alphabet {0,1,2,3}.
 // Uses a static model estimated from the symbol histogram.
 
 std::vector<uint8_t> ransEncode(const std::vector<int>& symbols);
-std::vector<int>     ransDecode(const std::vector<uint8_t>& stream);
\ No newline at end of file
+std::vector<int>     ransDecode(const std::vector<uint8_t>& stream);
+
+// Interleaved rANS: `lanes` (1, 2, 4 or 8) independent states share one
+// byte stream, symbol i being coded by state i % lanes. The lane count is
+// stored in the header after N.
+std::vector<uint8_t> ransEncodeInterleaved(const std::vector<int>& symbols,
+                                           int lanes);
+std::vector<int>     ransDecodeInterleaved(const std::vector<uint8_t>& stream);
+
+// 64-bit state with 32-bit word renormalization and 16-bit precision:
+// at most one branch-free renormalization step per symbol. Same varint
+// header as the byte/16-bit coders below.
+std::vector<uint8_t> ransEncode64(const std::vector<int>& symbols);
+std::vector<int>     ransDecode64(const std::vector<uint8_t>& stream);
+
+// Zero-copy decode: read the stream in place and write the symbols to
+// out[0, capacity). Returns the symbol count; throws if it exceeds
+// capacity. ransDecodedSize reads N from any of the u32-headed formats
+// (ransEncode, ransEncodeInterleaved, ransEncodeAdaptive, ransEncodeSimd,
+// tansEncode).
+size_t ransDecodedSize(const uint8_t* stream, size_t size);
+size_t ransDecode(const uint8_t* stream, size_t size, int* out, size_t capacity);
+size_t ransDecodeInterleaved(const uint8_t* stream, size_t size,
+                             int* out, size_t capacity);
+
+// Streaming decode of the ransEncode / ransEncodeInterleaved formats.
+// The states sit in front of the payload and the words are stored in
+// the order they are read, so decoding moves front to back and symbol
+// i needs only the bytes up to the words it consumes. Symbols reach
+// sink in order, in consecutive batches of at most RANS_DECODE_BATCH,
+// from a stack buffer that is reused once sink returns; no output of
+// size N is allocated. Returns the symbol count.
+constexpr size_t RANS_DECODE_BATCH = 4096;
+using RansSymbolSink = std::function<void(const uint8_t* symbols, size_t n)>;
+
+size_t ransDecode(const uint8_t* stream, size_t size, const RansSymbolSink& sink);
+size_t ransDecodeInterleaved(const uint8_t* stream, size_t size,
+                             const RansSymbolSink& sink);
+
+// uint8_t symbols, same formats as the int versions: a quarter of the
+// memory traffic. 2-bit packed symbols (symbol_pack.hpp) use the
+// ransEncodeInterleaved format; ransDecodePacked2 writes
+// packedSize2(N) bytes.
+std::vector<uint8_t> ransEncode(const std::vector<uint8_t>& symbols);
+std::vector<uint8_t> ransEncodeInterleaved(const std::vector<uint8_t>& symbols,
+                                           int lanes);
+std::vector<uint8_t> ransEncodePacked2(const uint8_t* packed, size_t n, int lanes);
+size_t ransDecode(const uint8_t* stream, size_t size, uint8_t* out, size_t capacity);
+size_t ransDecodeInterleaved(const uint8_t* stream, size_t size,
+                             uint8_t* out, size_t capacity);
+size_t ransDecodePacked2(const uint8_t* stream, size_t size,
+                         uint8_t* packed, size_t capacity);
+
+// Encode into out, replacing its contents but keeping its capacity: a
+// vector reused across calls makes steady-state encodes allocation-free.
+// Same formats as ransEncode / ransEncodeInterleaved.
+void ransEncode(const int* symbols, size_t n, std::vector<uint8_t>& out);
+void ransEncode(const uint8_t* symbols, size_t n, std::vector<uint8_t>& out);
+void ransEncodeInterleaved(const int* symbols, size_t n, int lanes,
+                           std::vector<uint8_t>& out);
+void ransEncodeInterleaved(const uint8_t* symbols, size_t n, int lanes,
+                           std::vector<uint8_t>& out);
+
+// Order-k context model (k = 1 or 2): one normalized table per context
+// of the k preceding symbols (4 or 16 tables), symbols before the start
+// taken as 0. The decoder selects each table from the symbols it has
+// already produced. Runs on the 64-bit engine; the header carries a
+// context mask and a compact varint table per context that occurs.
+std::vector<uint8_t> ransEncodeOrder(const std::vector<int>& symbols, int order);
+std::vector<uint8_t> ransEncodeOrder(const std::vector<uint8_t>& symbols, int order);
+std::vector<int>     ransDecodeOrder(const std::vector<uint8_t>& stream);
+size_t ransDecodeOrder(const uint8_t* stream, size_t size, int* out, size_t capacity);
+size_t ransDecodeOrder(const uint8_t* stream, size_t size, uint8_t* out, size_t capacity);
+
+// Small-message format: one table-id byte, N as a varint, and a final
+// state flushed in only the bytes it needs (1..8), since the encoder
+// starts from x = 1 instead of the full-width lower bound. Id 0 sends
+// the symbol counts inline (three varints); the built-in pre-trained
+// tables below, and any added with ransRegisterSmallModel, skip both
+// the table bytes and the histogram pass. RANS_SMALL_AUTO histograms
+// the input and picks the cheapest table. Runs on the 64-bit engine
+// with compare-based decoding, so no slot table is built per message.
+constexpr int RANS_SMALL_AUTO    = -1;
+constexpr int RANS_SMALL_INLINE  = 0;
+constexpr int RANS_SMALL_UNIFORM = 1; // 25/25/25/25
+constexpr int RANS_SMALL_P70     = 2; // 70/10/10/10
+constexpr int RANS_SMALL_LINEAR  = 3; // 40/30/20/10
+constexpr int RANS_SMALL_P97     = 4; // 97/1/1/1
+constexpr int RANS_SMALL_P999    = 5; // 99.9/0.04/0.04/0.02
+
+// Register a table normalized from counts; returns its id (6..255).
+// Encoder and decoder must register the same tables in the same order.
+// Thread-safe.
+int ransRegisterSmallModel(const std::array<uint32_t, 4>& counts);
+
+std::vector<uint8_t> ransEncodeSmall(const std::vector<int>& symbols,
+                                     int table = RANS_SMALL_AUTO);
+std::vector<uint8_t> ransEncodeSmall(const std::vector<uint8_t>& symbols,
+                                     int table = RANS_SMALL_AUTO);
+void ransEncodeSmall(const int* symbols, size_t n, int table, std::vector<uint8_t>& out);
+void ransEncodeSmall(const uint8_t* symbols, size_t n, int table, std::vector<uint8_t>& out);
+std::vector<int> ransDecodeSmall(const std::vector<uint8_t>& stream);
+size_t ransSmallDecodedSize(const uint8_t* stream, size_t size);
+size_t ransDecodeSmall(const uint8_t* stream, size_t size, int* out, size_t capacity);
+size_t ransDecodeSmall(const uint8_t* stream, size_t size, uint8_t* out, size_t capacity);
+
+// Byte and 16-bit alphabets on the same engine (see rans_codec.hpp): a
+// varint header with the frequencies of the symbols that occur, then
+// the payload. Bytes use 14-bit precision with a 32-bit state; 16-bit
+// values use 16-bit precision with a 64-bit state and 32-bit words.
+std::vector<uint8_t>  ransEncodeBytes(const std::vector<uint8_t>& bytes);
+std::vector<uint8_t>  ransDecodeBytes(const std::vector<uint8_t>& stream);
+std::vector<uint8_t>  ransEncode16(const std::vector<uint16_t>& values);
+std::vector<uint16_t> ransDecode16(const std::vector<uint8_t>& stream);
+
+// Adaptive rANS: no frequency header and no histogram pass. The model is
+// rebuilt every 1024 symbols from decayed running counts that the
+// decoder tracks identically; the stream is flushed every 16K symbols.
+std::vector<uint8_t> ransEncodeAdaptive(const std::vector<int>& symbols);
+std::vector<int>     ransDecodeAdaptive(const std::vector<uint8_t>& stream);
+
+// SIMD-friendly interleaved rANS: `lanes` (8, 16 or 32) 32-bit states with
+// 16-bit renormalization, so each lane reads at most one word per symbol.
+// The decoder picks an AVX2 kernel at runtime when the CPU supports it and
+// otherwise runs the equivalent scalar loop; both read the same format.
+enum class RansDecodeKernel {
+    Auto,
+    Scalar,
+    Avx2
+};
+
+std::vector<uint8_t> ransEncodeSimd(const std::vector<int>& symbols, int lanes);
+std::vector<uint8_t> ransEncodeSimd(const std::vector<uint8_t>& symbols, int lanes);
+std::vector<uint8_t> ransEncodeSimd(const int* symbols, size_t n, int lanes);
+std::vector<uint8_t> ransEncodeSimd(const uint8_t* symbols, size_t n, int lanes);
+std::vector<int>     ransDecodeSimd(const std::vector<uint8_t>& stream,
+                                    RansDecodeKernel kernel = RansDecodeKernel::Auto);
+size_t               ransDecodeSimd(const uint8_t* stream, size_t size,
+                                    int* out, size_t capacity,
+                                    RansDecodeKernel kernel = RansDecodeKernel::Auto);
+size_t               ransDecodeSimd(const uint8_t* stream, size_t size,
+                                    uint8_t* out, size_t capacity,
+                                    RansDecodeKernel kernel = RansDecodeKernel::Auto);
+
+// True when ransDecodeSimd's Auto mode will use a vector kernel.
+bool ransSimdAvailable();
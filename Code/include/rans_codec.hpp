@@ -0,0 +1,574 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "byte_io.hpp"
+#include "codec_trace.hpp"
+#include "rans_normalize.hpp"
+
+#if defined(_MSC_VER) && defined(_M_X64) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+// Generic rANS core, parameterized at compile time on
+//   AlphSize  - number of symbols (>= 2)
+//   ScaleBits - probability precision, frequencies sum to 2^ScaleBits
+//   State     - uint32_t or uint64_t coder state
+//   Word      - uint8_t, uint16_t or uint32_t renormalization unit
+//
+// The state lives in [L, L << WORD_BITS) with L = 2^(STATE_BITS -
+// WORD_BITS - 1), which keeps x below 2^(STATE_BITS - 1) so the encoder
+// can replace x / f by a reciprocal multiply. When WORD_BITS >= ScaleBits
+// one renormalization step per symbol is enough and both directions use
+// a branch-free select instead of a loop.
+//
+// The encoder runs backwards over the symbols and appends words in
+// encode order; once it is done the payload is reversed in place and the
+// final states are written in front of it, so the decoder reads the
+// stream front to back and needs only the bytes it has reached. Small
+// alphabets and slot tables are held in std::array, large
+// ones on the heap.
+
+inline uint32_t ransMulHi(uint32_t a, uint32_t b) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) >> 32);
+}
+
+inline uint64_t ransMulHi(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 Wide; // no -Wpedantic warning
+    return static_cast<uint64_t>((static_cast<Wide>(a) * b) >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64) && !defined(__clang__)
+    return __umulh(a, b);
+#else
+    const uint64_t aLo = a & 0xFFFFFFFFu, aHi = a >> 32;
+    const uint64_t bLo = b & 0xFFFFFFFFu, bHi = b >> 32;
+    const uint64_t u = aHi * bLo + (aLo * bLo >> 32);
+    const uint64_t w = aLo * bHi + (u & 0xFFFFFFFFu);
+    return aHi * bHi + (u >> 32) + (w >> 32);
+#endif
+}
+
+// Fixed-size table: inline storage up to 4096 entries, heap beyond.
+template <class T, size_t N, bool Inline = (N <= 4096)>
+struct RansTable {
+    std::array<T, N> v{};
+    T&       operator[](size_t i)       { return v[i]; }
+    const T& operator[](size_t i) const { return v[i]; }
+    T*       data()       { return v.data(); }
+    const T* data() const { return v.data(); }
+};
+
+template <class T, size_t N>
+struct RansTable<T, N, false> {
+    std::vector<T> v = std::vector<T>(N);
+    T&       operator[](size_t i)       { return v[i]; }
+    const T& operator[](size_t i) const { return v[i]; }
+    T*       data()       { return v.data(); }
+    const T* data() const { return v.data(); }
+};
+
+template <size_t AlphSize, int ScaleBits,
+          class State = uint32_t, class Word = uint8_t>
+class RansCodec {
+public:
+    static constexpr int STATE_BITS = 8 * static_cast<int>(sizeof(State));
+    static constexpr int WORD_BITS  = 8 * static_cast<int>(sizeof(Word));
+    static constexpr uint32_t TOTFREQ = 1u << ScaleBits;
+    static constexpr State L = State(1) << (STATE_BITS - WORD_BITS - 1);
+    static constexpr bool SINGLE_RENORM = WORD_BITS >= ScaleBits;
+
+    static_assert(std::is_same<State, uint32_t>::value ||
+                  std::is_same<State, uint64_t>::value, "State must be uint32_t or uint64_t");
+    static_assert(std::is_same<Word, uint8_t>::value || std::is_same<Word, uint16_t>::value ||
+                  std::is_same<Word, uint32_t>::value, "Word must be uint8_t, uint16_t or uint32_t");
+    static_assert(WORD_BITS < STATE_BITS, "Word must be narrower than State");
+    static_assert(AlphSize >= 2 && AlphSize <= TOTFREQ, "alphabet must fit in the precision");
+    static_assert(ScaleBits >= 1 && ScaleBits <= 16, "freq and cum are packed in 16 bits");
+    static_assert(ScaleBits <= STATE_BITS - WORD_BITS - 1, "precision too high for this state");
+
+    using Symbol = typename std::conditional<(AlphSize <= 256), uint8_t,
+                   typename std::conditional<(AlphSize <= 65536), uint16_t, uint32_t>::type>::type;
+
+    // Normalized frequencies; zero for symbols that never occur.
+    struct Model {
+        RansTable<uint32_t, AlphSize> freq;
+        RansTable<uint32_t, AlphSize> cum;
+    };
+
+    struct EncSymbol {
+        State    xMax;     // renormalize while x >= xMax
+        State    rcpFreq;  // ceil(2^(STATE_BITS - 1 + shift) / f)
+        uint32_t bias;
+        uint32_t cmplFreq; // TOTFREQ - f
+        uint32_t rcpShift;
+    };
+    using EncTable = RansTable<EncSymbol, AlphSize>;
+
+    // Tiny alphabets at high precision find the symbol with a few compares
+    // against cum[] instead of a slot table that would not fit in L1.
+    static constexpr bool SEARCH_DECODE = AlphSize <= 8 && ScaleBits > 12;
+
+    // One entry per slot: freq | cum << 16, plus the symbol.
+    struct SlotTable {
+        RansTable<uint32_t, TOTFREQ> freqCum;
+        RansTable<Symbol,   TOTFREQ> sym;
+    };
+    using DecTable = typename std::conditional<SEARCH_DECODE, Model, SlotTable>::type;
+
+    // ------------------------------
+    // Model construction
+    // ------------------------------
+
+    static void buildCumulative(Model& m) {
+        uint32_t c = 0;
+        for (size_t k = 0; k < AlphSize; ++k) {
+            m.cum[k] = c;
+            c += m.freq[k];
+        }
+    }
+
+    // Scale counts to TOTFREQ (see rans_normalize.hpp); every symbol
+    // with a nonzero count keeps a nonzero frequency.
+    static Model normalize(const RansTable<uint64_t, AlphSize>& counts) {
+        CODEC_STAGE(Normalize);
+        size_t used = 0;
+        size_t last = 0;
+        for (size_t k = 0; k < AlphSize; ++k) {
+            if (counts[k] == 0) continue;
+            ++used;
+            last = k;
+        }
+        if (used == 0) {
+            throw std::runtime_error("ransEncode: empty histogram");
+        }
+
+        Model m;
+        if (used == 1) {
+            // A lone symbol would need freq == TOTFREQ, which does not fit
+            // the 16-bit packing at ScaleBits == 16; give a neighbour one slot.
+            m.freq[last] = TOTFREQ - 1;
+            m.freq[(last + 1) % AlphSize] = 1;
+        } else {
+            ransNormalizeFreqs(counts.data(), AlphSize, TOTFREQ, m.freq.data());
+        }
+        buildCumulative(m);
+        return m;
+    }
+
+    template <class In>
+    static Model buildModel(const In* symbols, size_t n) {
+        RansTable<uint64_t, AlphSize> counts;
+        {
+            CODEC_STAGE(Histogram);
+            for (size_t i = 0; i < n; ++i) {
+                // Negative ints wrap to huge values and fail the same check.
+                const uint64_t s = static_cast<uint64_t>(symbols[i]);
+                if (s >= AlphSize) {
+                    throw std::runtime_error("ransEncode: symbol out of range");
+                }
+                counts[static_cast<size_t>(s)]++;
+            }
+        }
+        return normalize(counts);
+    }
+
+    static void buildEncTable(const Model& m, EncTable& t) {
+        for (size_t k = 0; k < AlphSize; ++k) {
+            const uint32_t f = m.freq[k];
+            EncSymbol& e = t[k];
+            if (f == 0) {
+                e = EncSymbol{};
+                continue;
+            }
+            e.xMax     = ((L >> ScaleBits) << WORD_BITS) * f;
+            e.cmplFreq = TOTFREQ - f;
+            if (f < 2) {
+                // q == x; mulhi(x, ~0) == x - 1 is fixed up by the bias.
+                e.rcpFreq  = ~State(0);
+                e.rcpShift = 0;
+                e.bias     = m.cum[k] + TOTFREQ - 1;
+            } else {
+                uint32_t shift = 0;
+                while (f > (1u << shift)) shift++;
+                e.rcpFreq  = reciprocal(f, shift);
+                e.rcpShift = shift - 1;
+                e.bias     = m.cum[k];
+            }
+        }
+    }
+
+    static void buildDecTable(const Model& m, DecTable& t) {
+        if constexpr (SEARCH_DECODE) {
+            t = m;
+            return;
+        } else {
+            buildSlotTable(m, t);
+        }
+    }
+
+    static void buildSlotTable(const Model& m, SlotTable& t) {
+        for (size_t k = 0; k < AlphSize; ++k) {
+            const uint32_t lo = m.cum[k];
+            const uint32_t hi = lo + m.freq[k];
+            const uint32_t packed = m.freq[k] | (lo << 16);
+            std::fill(t.freqCum.data() + lo, t.freqCum.data() + hi, packed);
+            std::fill(t.sym.data() + lo, t.sym.data() + hi, static_cast<Symbol>(k));
+        }
+    }
+
+    // ------------------------------
+    // Coding steps
+    // ------------------------------
+
+    static void encodeSymbol(State& x, std::vector<uint8_t>& out, const EncSymbol& e) {
+        if (SINGLE_RENORM) {
+            if (x >= e.xMax) {
+                putWord(out, static_cast<Word>(x));
+                x >>= WORD_BITS;
+            }
+        } else {
+            while (x >= e.xMax) {
+                putWord(out, static_cast<Word>(x));
+                x >>= WORD_BITS;
+            }
+        }
+        const State q = ransMulHi(x, e.rcpFreq) >> e.rcpShift;
+        x += e.bias + q * e.cmplFreq;
+    }
+
+    // Single-step encoder into a preallocated buffer: the word is always
+    // stored and the cursor only advances when it was needed, so there is
+    // no data-dependent branch.
+    static void encodeSymbol(State& x, uint8_t*& p, const EncSymbol& e) {
+        static_assert(SINGLE_RENORM, "branch-free step needs single-step renormalization");
+        const bool emit = x >= e.xMax;
+        storeWord(p, static_cast<Word>(x));
+        p += emit ? sizeof(Word) : 0;
+        x = emit ? (x >> WORD_BITS) : x;
+        const State q = ransMulHi(x, e.rcpFreq) >> e.rcpShift;
+        x += e.bias + q * e.cmplFreq;
+    }
+
+    // data[idx, end) holds the words not yet consumed, and at least
+    // sizeof(Word) readable bytes precede end (the states always do).
+    static Symbol decodeSymbol(State& x, const uint8_t* data, size_t& idx,
+                               size_t end, const DecTable& t)
+    {
+        const uint32_t slot = static_cast<uint32_t>(x) & (TOTFREQ - 1);
+        size_t s;
+        if constexpr (SEARCH_DECODE) {
+            // cum[] is non-decreasing, so the count of cum[k] <= slot is the
+            // last symbol starting at or below slot.
+            s = 0;
+            for (size_t k = 1; k < AlphSize; ++k) s += t.cum[k] <= slot;
+            x = static_cast<State>(t.freq[s]) * (x >> ScaleBits) + slot - t.cum[s];
+        } else {
+            const uint32_t fc = t.freqCum[slot];
+            x = static_cast<State>(fc & 0xFFFFu) * (x >> ScaleBits) + slot - (fc >> 16);
+            s = slot;
+        }
+
+        if (SINGLE_RENORM) {
+            // Branch-free: the load falls back to the last word before
+            // end, which is in bounds because the states precede the payload.
+            const bool take = (x < L) & (idx + sizeof(Word) <= end);
+            const size_t pos = take ? idx : end - sizeof(Word);
+            const State w = getWord(data + pos);
+            x   = take ? ((x << WORD_BITS) | w) : x;
+            idx = take ? idx + sizeof(Word) : idx;
+        } else {
+            while (x < L && idx + sizeof(Word) <= end) {
+                x = (x << WORD_BITS) | getWord(data + idx);
+                idx += sizeof(Word);
+            }
+        }
+        if constexpr (SEARCH_DECODE) {
+            return static_cast<Symbol>(s);
+        } else {
+            return t.sym[s];
+        }
+    }
+
+    static void storeState(uint8_t* p, State x) {
+        for (size_t i = 0; i < sizeof(State); ++i) {
+            p[i] = static_cast<uint8_t>(x >> (8 * i));
+        }
+    }
+
+    // Read the state stored at idx and step past it.
+    static State getState(const uint8_t* data, size_t& idx) {
+        State x = 0;
+        for (size_t i = 0; i < sizeof(State); ++i) {
+            x |= static_cast<State>(data[idx + i]) << (8 * i);
+        }
+        idx += sizeof(State);
+        return x;
+    }
+
+    // Reverse the order of the words in [first, last), keeping the bytes
+    // of each word in place: turns encode order into decode order.
+    static void reverseWords(uint8_t* first, uint8_t* last) {
+        if constexpr (sizeof(Word) == 1) {
+            std::reverse(first, last);
+        } else {
+            while (last - first >= static_cast<std::ptrdiff_t>(2 * sizeof(Word))) {
+                last -= sizeof(Word);
+                Word a, b;
+                std::memcpy(&a, first, sizeof(Word));
+                std::memcpy(&b, last, sizeof(Word));
+                std::memcpy(first, &b, sizeof(Word));
+                std::memcpy(last, &a, sizeof(Word));
+                first += sizeof(Word);
+            }
+        }
+    }
+
+    // ------------------------------
+    // Interleaved lanes
+    // ------------------------------
+
+    // Symbol i is coded by state i % Lanes; symbols go in reverse so that
+    // decoding runs forward. Layout: the final states, lane 0 first, then
+    // the payload in decode order. Src is anything indexable with
+    // symbols[i]: a pointer, or a view such as Packed2View.
+    template <int Lanes, class Src>
+    static void encodeLanes(Src symbols, size_t n, const EncTable& t,
+                            std::vector<uint8_t>& out)
+    {
+        CODEC_STAGE(Encode);
+        CODEC_COUNT(RansEncodeSymbols, n);
+        const size_t start = out.size();
+        const size_t base = start + Lanes * sizeof(State);
+        std::array<State, Lanes> x;
+        x.fill(L);
+
+        const size_t full = n - n % Lanes;
+        if constexpr (SINGLE_RENORM) {
+            // At most one word per symbol, plus one of slack for the
+            // unconditional store.
+            out.resize(base + (n + 1) * sizeof(Word));
+            uint8_t* p = out.data() + base;
+            for (size_t i = n; i-- > full; ) {
+                encodeSymbol(x[i % Lanes], p, t[static_cast<size_t>(symbols[i])]);
+            }
+            for (size_t i = full; i > 0; i -= Lanes) {
+                for (int j = Lanes - 1; j >= 0; --j) {
+                    encodeSymbol(x[j], p, t[static_cast<size_t>(symbols[i - Lanes + j])]);
+                }
+            }
+            out.resize(static_cast<size_t>(p - out.data()));
+        } else {
+            out.resize(base);
+            for (size_t i = n; i-- > full; ) {
+                encodeSymbol(x[i % Lanes], out, t[static_cast<size_t>(symbols[i])]);
+            }
+            for (size_t i = full; i > 0; i -= Lanes) {
+                for (int j = Lanes - 1; j >= 0; --j) {
+                    encodeSymbol(x[j], out, t[static_cast<size_t>(symbols[i - Lanes + j])]);
+                }
+            }
+        }
+        // Words are counted from the output size, not per symbol.
+        CODEC_COUNT(RansWordsOut, (out.size() - base) / sizeof(Word));
+        reverseWords(out.data() + base, out.data() + out.size());
+        for (int j = 0; j < Lanes; ++j) storeState(out.data() + start + j * sizeof(State), x[j]);
+        CODEC_COUNT(RansBytesOut, out.size() - start);
+    }
+
+    // Dst is anything assignable through out[i]: a pointer or a view.
+    template <int Lanes, class Dst>
+    static void decodeLanes(const uint8_t* data, size_t dataStart, size_t end,
+                            const DecTable& t, Dst out, size_t n)
+    {
+        CODEC_STAGE(Decode);
+        CODEC_COUNT(RansDecodeSymbols, n);
+        LaneCursor<Lanes> c = openLanes<Lanes>(data, dataStart, end);
+        decodeRun(c, data, t, out, n);
+        CODEC_COUNT(RansWordsIn, (c.idx - dataStart - Lanes * sizeof(State)) / sizeof(Word));
+    }
+
+    // Same symbols as decodeLanes, handed to sink(const Symbol*, size_t)
+    // in order through a stack buffer of Batch symbols, so the caller
+    // can consume them as they are produced without a full-size output.
+    template <int Lanes, size_t Batch, class Sink>
+    static void decodeLanesBatched(const uint8_t* data, size_t dataStart, size_t end,
+                                   const DecTable& t, size_t n, Sink&& sink)
+    {
+        static_assert(Batch % Lanes == 0, "batches must start on lane 0");
+        CODEC_STAGE(Decode);
+        CODEC_COUNT(RansDecodeSymbols, n);
+        LaneCursor<Lanes> c = openLanes<Lanes>(data, dataStart, end);
+        std::array<Symbol, Batch> buf;
+        for (size_t i = 0; i < n; i += Batch) {
+            const size_t k = std::min(Batch, n - i);
+            decodeRun(c, data, t, buf.data(), k);
+            sink(static_cast<const Symbol*>(buf.data()), k);
+        }
+        CODEC_COUNT(RansWordsIn, (c.idx - dataStart - Lanes * sizeof(State)) / sizeof(Word));
+    }
+
+    // ------------------------------
+    // Self-describing stream
+    // ------------------------------
+    //
+    // Layout: N (varint) + K (varint) + K x (symbol gap, freq) varints for
+    // the symbols that occur + final state + payload.
+
+    static void writeModel(std::vector<uint8_t>& out, const Model& m) {
+        size_t used = 0;
+        for (size_t k = 0; k < AlphSize; ++k) used += m.freq[k] != 0;
+        writeVarint(out, used);
+        size_t prev = 0;
+        for (size_t k = 0; k < AlphSize; ++k) {
+            if (m.freq[k] == 0) continue;
+            writeVarint(out, k - prev);
+            writeVarint(out, m.freq[k]);
+            prev = k + 1;
+        }
+    }
+
+    static Model readModel(const std::vector<uint8_t>& in, size_t& offset) {
+        Model m;
+        const uint64_t used = readVarint(in, offset);
+        if (used == 0 || used > AlphSize) {
+            throw std::runtime_error("ransDecode: bad frequency table");
+        }
+        uint64_t k = 0;
+        uint64_t total = 0;
+        for (uint64_t i = 0; i < used; ++i) {
+            k += readVarint(in, offset);
+            const uint64_t f = readVarint(in, offset);
+            if (k >= AlphSize || f == 0 || f > TOTFREQ) {
+                throw std::runtime_error("ransDecode: bad frequency table");
+            }
+            m.freq[static_cast<size_t>(k)] = static_cast<uint32_t>(f);
+            total += f;
+            ++k;
+        }
+        if (total != TOTFREQ) {
+            throw std::runtime_error("ransDecode: totalFreq != TOTFREQ");
+        }
+        buildCumulative(m);
+        return m;
+    }
+
+    template <class In>
+    static std::vector<uint8_t> encode(const In* symbols, size_t n) {
+        if (n == 0) return {};
+        const Model m = buildModel(symbols, n);
+        EncTable t;
+        buildEncTable(m, t);
+
+        std::vector<uint8_t> out;
+        out.reserve(16 + n * sizeof(Symbol));
+        writeVarint(out, n);
+        writeModel(out, m);
+        encodeLanes<1>(symbols, n, t, out);
+        return out;
+    }
+
+    static std::vector<Symbol> decode(const std::vector<uint8_t>& stream) {
+        return decodeAs<Symbol>(stream);
+    }
+
+    // Same as decode() but widens straight into Out, e.g. int.
+    template <class Out>
+    static std::vector<Out> decodeAs(const std::vector<uint8_t>& stream) {
+        if (stream.empty()) return {};
+        size_t offset = 0;
+        const uint64_t n = readVarint(stream, offset);
+        const Model m = readModel(stream, offset);
+        DecTable t;
+        buildDecTable(m, t);
+
+        std::vector<Out> out(static_cast<size_t>(n));
+        decodeLanes<1>(stream.data(), offset, stream.size(), t, out.data(), out.size());
+        return out;
+    }
+
+private:
+    // Decoder position: the lane states and the next word to read.
+    template <int Lanes>
+    struct LaneCursor {
+        std::array<State, Lanes> x;
+        size_t idx;
+        size_t end;
+    };
+
+    template <int Lanes>
+    static LaneCursor<Lanes> openLanes(const uint8_t* data, size_t dataStart, size_t end) {
+        if (end < dataStart + Lanes * sizeof(State)) {
+            throw std::runtime_error("ransDecode: not enough bytes for final state");
+        }
+        LaneCursor<Lanes> c;
+        c.idx = dataStart;
+        c.end = end;
+        for (int j = 0; j < Lanes; ++j) c.x[j] = getState(data, c.idx);
+        return c;
+    }
+
+    // Decode the next n symbols; the first goes to lane 0.
+    template <int Lanes, class Dst>
+    static void decodeRun(LaneCursor<Lanes>& c, const uint8_t* data,
+                          const DecTable& t, Dst out, size_t n)
+    {
+        std::array<State, Lanes> x = c.x;
+        size_t idx = c.idx;
+        const size_t end = c.end;
+        const size_t full = n - n % Lanes;
+        for (size_t i = 0; i < full; i += Lanes) {
+            for (int j = 0; j < Lanes; ++j) {
+                out[i + j] = decodeSymbol(x[j], data, idx, end, t);
+            }
+        }
+        for (size_t i = full; i < n; ++i) {
+            out[i] = decodeSymbol(x[i % Lanes], data, idx, end, t);
+        }
+        c.x = x;
+        c.idx = idx;
+    }
+
+    static State reciprocal(uint32_t f, uint32_t shift) {
+        if (STATE_BITS == 32) {
+            return static_cast<State>(((1ull << (shift + 31)) + f - 1) / f);
+        }
+        // ceil(2^(63 + shift) / f) via two 64-by-32 divisions.
+        uint64_t x1 = 1ull << (shift + 31);
+        uint64_t t1 = x1 / f;
+        uint64_t x0 = (f - 1) + ((x1 % f) << 32);
+        uint64_t t0 = x0 / f;
+        return static_cast<State>(t0 + (t1 << 32));
+    }
+
+    static void putWord(std::vector<uint8_t>& out, Word w) {
+        for (size_t i = 0; i < sizeof(Word); ++i) {
+            out.push_back(static_cast<uint8_t>(w >> (8 * i)));
+        }
+    }
+
+    static void storeWord(uint8_t* p, Word w) {
+        for (size_t i = 0; i < sizeof(Word); ++i) {
+            p[i] = static_cast<uint8_t>(w >> (8 * i));
+        }
+    }
+
+    static State getWord(const uint8_t* p) {
+        State w = 0;
+        for (size_t i = 0; i < sizeof(Word); ++i) {
+            w |= static_cast<State>(p[i]) << (8 * i);
+        }
+        return w;
+    }
+};
+
+// Common configurations.
+using Rans4Codec    = RansCodec<4, 12, uint32_t, uint8_t>;       // ransEncode
+using RansByteCodec = RansCodec<256, 14, uint32_t, uint8_t>;    // raw bytes
+using Rans16Codec   = RansCodec<65536, 16, uint64_t, uint32_t>; // 16-bit values
+using Rans64Codec   = RansCodec<4, 16, uint64_t, uint32_t>;     // ransEncode64
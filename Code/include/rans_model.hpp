@@ -0,0 +1,34 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Static order-0 model shared by the rANS stream variants.
+
+constexpr int      RANS_ALPH_SIZE  = 4;
+constexpr uint32_t RANS_SCALE_BITS = 12;
+constexpr uint32_t RANS_TOTFREQ    = 1u << RANS_SCALE_BITS; // 4096
+
+// Normalized frequencies (sum == RANS_TOTFREQ, each >= 1) plus
+// cumulative starts.
+struct RansModel {
+    std::array<uint16_t, RANS_ALPH_SIZE> freq{};
+    std::array<uint16_t, RANS_ALPH_SIZE> cum{};
+};
+
+void ransBuildCumulative(RansModel& m);
+
+// Histogram the input and normalize it; throws on symbols outside 0..3.
+RansModel ransBuildModel(const std::vector<int>& symbols);
+RansModel ransBuildModel(const int* symbols, size_t n);
+RansModel ransBuildModel(const uint8_t* symbols, size_t n);
+RansModel ransBuildModelPacked2(const uint8_t* packed, size_t n); // symbol_pack.hpp layout
+
+// Normalize raw symbol counts (not all zero).
+RansModel ransModelFromCounts(const std::array<uint32_t, RANS_ALPH_SIZE>& counts);
+
+// Serialize / parse freq[0..3] as u16 LE.
+void      ransWriteModel(std::vector<uint8_t>& out, const RansModel& m);
+RansModel ransReadModel(const std::vector<uint8_t>& stream, size_t& offset);
+RansModel ransReadModel(const uint8_t* stream, size_t size, size_t& offset);
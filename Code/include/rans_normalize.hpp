@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Frequency normalization shared by every static and adaptive model
+// (rans_model.hpp, rans_codec.hpp, tANS, the adaptive rebuilds).
+//
+// counts[0, n) are scaled to integer freq[0, n) summing to totFreq,
+// choosing the rounding that minimizes the coded size
+// sum(-counts[k] * log2(freq[k] / totFreq)): start from the exact share
+// rounded to nearest through a 32.32 fixed-point reciprocal (at least 1
+// for a symbol that occurs), then hand the missing slots to, or take the
+// extra ones from, the symbols where that changes the size least. Each
+// step is a heap operation and there are at most n steps, so the cost
+// is O(n log n) for any totFreq.
+//
+// Slot costs are compared with the integer approximation
+// log2((f + 1) / f) ~ 1 / (f + 1/2), with ties going to the lower
+// symbol, so encoders and the adaptive decoders agree bit for bit on
+// every platform.
+//
+// Symbols with a zero count get frequency 0, or 1 with keepAbsent for
+// formats that cannot describe an absent symbol. Throws if all counts
+// are zero or the symbols that need a slot outnumber totFreq.
+void ransNormalizeFreqs(const uint64_t* counts, size_t n, uint32_t totFreq,
+                        uint32_t* freq, bool keepAbsent = false);
@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+// Block-framed streaming rANS. Symbols are cut into blocks of at most
+// blockSize symbols; each block is an independent interleaved rANS
+// stream (its own frequency header) framed as
+//   compressedSize (u32 LE) + ransEncodeInterleaved(block, 4)
+// and the stream ends with a zero size. Encoder and decoder each hold
+// one block in memory, as uint8_t symbols. The decoder reads a block
+// at most RANS_STREAM_READ_CHUNK bytes at a time, so a corrupt size
+// field costs no more memory than the input actually supplies.
+
+constexpr size_t RANS_STREAM_DEFAULT_BLOCK = size_t(1) << 16;
+constexpr size_t RANS_STREAM_READ_CHUNK    = size_t(1) << 20;
+
+class RansStreamEncoder {
+public:
+    explicit RansStreamEncoder(std::ostream& out,
+                               size_t blockSize = RANS_STREAM_DEFAULT_BLOCK);
+
+    // Throw on a symbol outside 0..3.
+    void put(int symbol);
+    void write(const int* symbols, size_t n);
+    void write(const uint8_t* symbols, size_t n);
+
+    template <class It>
+    void write(It first, It last) {
+        for (; first != last; ++first) put(*first);
+    }
+
+    // Encode the partial block and write the end marker.
+    void finish();
+private:
+    template <class Sym>
+    void writeImpl(const Sym* symbols, size_t n);
+    void flushBlock();
+
+    std::ostream& out_;
+    size_t blockSize_;
+    std::vector<uint8_t> block_;
+    std::vector<uint8_t> packed_;
+    bool finished_ = false;
+};
+
+class RansStreamDecoder {
+public:
+    explicit RansStreamDecoder(std::istream& in);
+
+    // Decode the next block into out; false once the end marker is read.
+    bool nextBlock(std::vector<int>& out);
+    bool nextBlock(std::vector<uint8_t>& out);
+
+    // Copy up to n symbols into dst, decoding blocks as needed.
+    // Returns the number of symbols written (0 at end of stream).
+    size_t read(int* dst, size_t n);
+    size_t read(uint8_t* dst, size_t n);
+private:
+    bool readBlock(); // next block's bytes into packed_
+    template <class Out>
+    bool nextBlockImpl(std::vector<Out>& out);
+    template <class Out>
+    size_t readImpl(Out* dst, size_t n);
+
+    std::istream& in_;
+    std::vector<uint8_t> packed_;
+    std::vector<uint8_t> block_;
+    size_t blockPos_ = 0;
+    bool done_ = false;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// 2-bit packed symbols {0,1,2,3}: symbol i lives in bits 2 * (i % 4) of
+// byte i / 4; bits past the last symbol are zero. A quarter of the size
+// of uint8_t symbols and a sixteenth of std::vector<int>.
+
+inline size_t packedSize2(size_t n) { return (n + 3) / 4; }
+
+std::vector<uint8_t> packSymbols2(const uint8_t* symbols, size_t n);
+void                 unpackSymbols2(const uint8_t* packed, size_t n, uint8_t* out);
+
+// Indexed read access, usable wherever the coders take a symbol source.
+struct Packed2View {
+    const uint8_t* data;
+    uint8_t operator[](size_t i) const {
+        return static_cast<uint8_t>((data[i >> 2] >> (2 * (i & 3))) & 3u);
+    }
+};
+
+// Indexed write access into a zeroed packed buffer; each symbol is
+// written once.
+struct Packed2Sink {
+    uint8_t* data;
+    struct Ref {
+        uint8_t* byte;
+        int shift;
+        Ref& operator=(uint8_t s) {
+            *byte = static_cast<uint8_t>(*byte | (s << shift));
+            return *this;
+        }
+    };
+    Ref operator[](size_t i) const {
+        return Ref{data + (i >> 2), static_cast<int>(2 * (i & 3))};
+    }
+};
@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+// Statistics for the 4-symbol alphabet: histograms that never store and
+// reload the same counter back to back, entropy from a log2 table, and
+// per-codec size estimates taken on a sample. Estimating a block costs a
+// few microseconds regardless of its size, so a codec can be picked per
+// block before anything is encoded.
+
+struct SymbolHistogram {
+    std::array<uint64_t, 4> counts{};
+
+    uint64_t total() const { return counts[0] + counts[1] + counts[2] + counts[3]; }
+};
+
+// Order-1 counts: pairs[prev * 4 + cur], the symbol before the first
+// taken as prev (0 at the start of a stream, as the coders do).
+struct PairHistogram {
+    std::array<uint64_t, 16> pairs{};
+
+    SymbolHistogram symbols() const; // marginal counts of cur
+};
+
+// Throw on symbols outside 0..3. The uint8_t histogram counts eight
+// symbols per 64-bit word, one byte lane each.
+SymbolHistogram symbolHistogram(const uint8_t* symbols, size_t n);
+SymbolHistogram symbolHistogram(const int* symbols, size_t n);
+PairHistogram   pairHistogram(const uint8_t* symbols, size_t n, unsigned prev = 0);
+PairHistogram   pairHistogram(const int* symbols, size_t n, unsigned prev = 0);
+
+// Chunks of the input histogrammed on the pool and summed.
+SymbolHistogram symbolHistogram(const uint8_t* symbols, size_t n, ThreadPool& pool);
+
+// log2(x) (0 at x == 0): exact from the table below 1024, interpolated
+// above it, error under 1e-6.
+double fastLog2(uint64_t x);
+
+// Ideal order-0 size in bits of data with these counts:
+// total * log2(total) - sum c * log2(c).
+double entropyBits(const uint64_t* counts, size_t k);
+
+// Bits per symbol; 0 for empty input.
+double symbolEntropy(const SymbolHistogram& h);
+double conditionalEntropy(const PairHistogram& h); // given the previous symbol
+double binaryEntropy(uint64_t ones, uint64_t n);   // bits per bin
+
+// ------------------------------
+// Codec selection
+// ------------------------------
+
+enum class CodecChoice : uint8_t {
+    RansOrder0 = 0, // ransEncode
+    RansOrder1 = 1, // ransEncodeOrder(..., 1)
+    Cabac      = 2, // cabacEncodeSymbols, Good, BinIndexPrevSymbol
+    Raw        = 3, // packSymbols2
+    Count
+};
+
+constexpr size_t CODEC_CHOICE_COUNT   = static_cast<size_t>(CodecChoice::Count);
+constexpr size_t STATS_DEFAULT_SAMPLE = 4096;
+
+const char* codecChoiceName(CodecChoice c);
+
+struct CodecEstimate {
+    std::array<double, CODEC_CHOICE_COUNT> bytes{}; // predicted stream size
+    double entropy0 = 0.0;  // bits/symbol, order-0
+    double entropy1 = 0.0;  // bits/symbol, order-1
+    size_t sampled  = 0;    // symbols the estimate was taken from
+    CodecChoice best = CodecChoice::Raw;
+
+    double size(CodecChoice c) const { return bytes[static_cast<size_t>(c)]; }
+};
+
+// Predict each codec's output size from the order-1 counts of at most
+// `sample` symbols, read as 16 evenly spaced runs (all of them when
+// n <= sample), scaled to n. Headers, the rANS table cost and CABAC's
+// probability floor and adaptation are modelled; within a few percent
+// of the real sizes on stationary data. Throws on symbols outside 0..3
+// in the sample.
+CodecEstimate estimateCodecs(const uint8_t* symbols, size_t n,
+                             size_t sample = STATS_DEFAULT_SAMPLE);
+CodecEstimate estimateCodecs(const int* symbols, size_t n,
+                             size_t sample = STATS_DEFAULT_SAMPLE);
+
+// One estimate per blockSize block (the last may be shorter), computed
+// on the pool.
+std::vector<CodecEstimate> estimateBlocks(const uint8_t* symbols, size_t n,
+                                          size_t blockSize, ThreadPool& pool,
+                                          size_t sample = STATS_DEFAULT_SAMPLE);
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Tabled ANS (FSE-style) coder for the 4-symbol alphabet {0,1,2,3}.
+// Built from the same normalized frequencies as ransEncode, with one
+// state per slot (table log RANS_SCALE_BITS). Decoding a symbol is a
+// single table lookup plus a bit read, with no multiply.
+//
+// Layout: N (u32) + freq[0..3] (u16) + LSB-first bit stream holding the
+// initial decoder state followed by each symbol's state bits in order.
+
+std::vector<uint8_t> tansEncode(const std::vector<int>& symbols);
+std::vector<int>     tansDecode(const std::vector<uint8_t>& stream);
+
+// uint8_t symbols, same format.
+std::vector<uint8_t> tansEncode(const std::vector<uint8_t>& symbols);
+std::vector<uint8_t> tansEncode(const int* symbols, size_t n);
+std::vector<uint8_t> tansEncode(const uint8_t* symbols, size_t n);
+
+// Zero-copy decode into out[0, capacity); returns the symbol count and
+// throws if it exceeds capacity.
+size_t tansDecode(const uint8_t* stream, size_t size, int* out, size_t capacity);
+size_t tansDecode(const uint8_t* stream, size_t size, uint8_t* out, size_t capacity);
@@ -0,0 +1,58 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool. Tasks run in FIFO order; results and exceptions
+// come back through std::future.
+class ThreadPool {
+public:
+    // threads == 0 picks std::thread::hardware_concurrency().
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    template <class F>
+    auto submit(F&& f) -> std::future<decltype(f())> {
+        using R = decltype(f());
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> result = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return result;
+    }
+
+    // Run fn(i) for every i in [0, n) on at most maxRunners workers (0 =
+    // all of them) and wait for all of them. The first exception thrown
+    // by fn is rethrown here.
+    void parallelFor(size_t n, const std::function<void(size_t)>& fn,
+                     unsigned maxRunners = 0);
+private:
+    void enqueue(std::function<void()> job);
+    void workerLoop();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+};
+
+// Process-wide pool with one worker per hardware thread, started on
+// first use. Codecs that take a thread count run on it, so a call does
+// not spawn and join its own threads.
+ThreadPool& sharedThreadPool();
+
+// fn(i) for every i in [0, n): inline when threads == 1 or n <= 1,
+// otherwise on at most threads workers of the shared pool (0 = all).
+void parallelForThreads(size_t n, unsigned threads,
+                        const std::function<void(size_t)>& fn);
@@ -0,0 +1,19 @@
+#include "bin_string.hpp"
+
+#include <bitset>
+
+size_t BinString::countOnes() const {
+    size_t n = 0;
+    for (size_t i = 0; i < wordCount(); ++i) {
+        n += std::bitset<64>(words_[i]).count();
+    }
+    return n;
+}
+
+bool BinString::operator==(const BinString& o) const {
+    if (size_ != o.size_) return false;
+    for (size_t i = 0; i < wordCount(); ++i) {
+        if (words_[i] != o.words_[i]) return false;
+    }
+    return true;
+}
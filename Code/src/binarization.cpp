@@ -0,0 +1,245 @@
+#include "binarization.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+Binarization::Binarization(std::vector<BinCode> codes)
+    : codes_(std::move(codes))
+{
+    if (codes_.empty() || codes_.size() > 65536) {
+        throw std::runtime_error("Binarization: need 1..65536 symbols");
+    }
+    for (const BinCode& c : codes_) {
+        if (c.len < 1 || c.len > BIN_MAX_CODE_LEN ||
+            (c.len < 32 && (c.code >> c.len) != 0)) {
+            throw std::runtime_error("Binarization: bad codeword");
+        }
+        maxLen_ = c.len > maxLen_ ? c.len : maxLen_;
+    }
+
+    peek_ = maxLen_ < BIN_MAX_PEEK ? maxLen_ : BIN_MAX_PEEK;
+    table_.resize(size_t(1) << peek_);
+    if (!fillDecodeTable(codes_.data(), codes_.size(), peek_, table_.data())) {
+        throw std::runtime_error("Binarization: code is not prefix-free");
+    }
+
+    // Long codewords are kept sorted by their MSB-first value aligned to
+    // maxLen_ bins. Prefix-free means the ranges each one covers are
+    // disjoint, and the only candidate for a window is the last key at or
+    // below it.
+    std::vector<std::pair<uint64_t, uint32_t>> longs;
+    for (size_t s = 0; s < codes_.size(); ++s) {
+        const BinCode& c = codes_[s];
+        if (c.len <= peek_) continue;
+        if (table_[c.code & ((1u << peek_) - 1)].len != 0) {
+            throw std::runtime_error("Binarization: code is not prefix-free");
+        }
+        longs.emplace_back(uint64_t(reverseBins(c.code, c.len)) << (maxLen_ - c.len),
+                           static_cast<uint32_t>(s));
+    }
+    std::sort(longs.begin(), longs.end());
+    for (size_t i = 0; i < longs.size(); ++i) {
+        const int len = codes_[longs[i].second].len;
+        const uint64_t end = longs[i].first + (uint64_t(1) << (maxLen_ - len));
+        if (i + 1 < longs.size() && end > longs[i + 1].first) {
+            throw std::runtime_error("Binarization: code is not prefix-free");
+        }
+        longKeys_.push_back(longs[i].first);
+        longCodes_.push_back(longs[i].second);
+    }
+}
+
+Binarization Binarization::fixedLength(int bits) {
+    if (bits < 1 || bits > 16) {
+        throw std::runtime_error("Binarization::fixedLength: bits must be 1..16");
+    }
+    std::vector<BinCode> codes(size_t(1) << bits);
+    for (size_t v = 0; v < codes.size(); ++v) codes[v] = fixedLengthCode(static_cast<unsigned>(v), bits);
+    return Binarization(std::move(codes));
+}
+
+Binarization Binarization::truncatedUnary(unsigned cMax) {
+    if (cMax < 1 || cMax > BIN_MAX_CODE_LEN) {
+        throw std::runtime_error("Binarization::truncatedUnary: cMax must be 1..32");
+    }
+    std::vector<BinCode> codes(cMax + 1);
+    for (unsigned v = 0; v <= cMax; ++v) codes[v] = truncatedUnaryCode(v, cMax);
+    return Binarization(std::move(codes));
+}
+
+// k-th order Exp-Golomb as in the H.264 UEGk suffix: a one per doubling
+// of the bucket size, a zero, then k + ones bins of the offset.
+Binarization Binarization::expGolomb(int k, unsigned alphabetSize) {
+    if (k < 0 || k > 16 || alphabetSize < 1) {
+        throw std::runtime_error("Binarization::expGolomb: bad parameters");
+    }
+    std::vector<BinCode> codes(alphabetSize);
+    for (unsigned s = 0; s < alphabetSize; ++s) {
+        uint64_t v = s;
+        int kk = k;
+        uint64_t code = 0;
+        int len = 0;
+        while (v >= (uint64_t(1) << kk)) {
+            code |= uint64_t(1) << len++;
+            v -= uint64_t(1) << kk;
+            ++kk;
+        }
+        ++len; // terminating zero
+        code |= uint64_t(reverseBins(static_cast<uint32_t>(v), kk)) << len;
+        len += kk;
+        if (len > BIN_MAX_CODE_LEN) {
+            throw std::runtime_error("Binarization::expGolomb: codeword longer than 32 bins");
+        }
+        codes[s] = BinCode{static_cast<uint32_t>(code), len};
+    }
+    return Binarization(std::move(codes));
+}
+
+// Truncated unary prefix of v >> k (cMax >> k) and k suffix bins. The
+// suffix is always present, so the code stays prefix-free for any cMax.
+Binarization Binarization::truncatedRice(int k, unsigned cMax) {
+    if (k < 0 || k > 16 || (cMax >> k) < 1 || (cMax >> k) + 1 + k > BIN_MAX_CODE_LEN) {
+        throw std::runtime_error("Binarization::truncatedRice: bad parameters");
+    }
+    std::vector<BinCode> codes(cMax + 1);
+    for (unsigned v = 0; v <= cMax; ++v) {
+        const BinCode p = truncatedUnaryCode(v >> k, cMax >> k);
+        const BinCode sfx = fixedLengthCode(v & ((1u << k) - 1), k);
+        codes[v] = BinCode{p.code | (sfx.code << p.len), p.len + k};
+    }
+    return Binarization(std::move(codes));
+}
+
+BinCode Binarization::code(unsigned symbol) const {
+    if (symbol >= codes_.size()) {
+        throw std::runtime_error("Binarization: symbol out of range");
+    }
+    return codes_[symbol];
+}
+
+template <class Sym>
+BinString Binarization::binarizeImpl(const Sym* symbols, size_t n) const {
+    BinString bins;
+    bins.reserve(n * static_cast<size_t>(maxLen_));
+    for (size_t i = 0; i < n; ++i) {
+        const unsigned s = static_cast<unsigned>(symbols[i]);
+        if (s >= codes_.size()) {
+            throw std::runtime_error("Binarization: symbol out of range");
+        }
+        bins.append(codes_[s].code, codes_[s].len);
+    }
+    return bins;
+}
+
+BinString Binarization::binarize(const std::vector<int>& symbols) const {
+    return binarizeImpl(symbols.data(), symbols.size());
+}
+
+BinString Binarization::binarize(const std::vector<uint8_t>& symbols) const {
+    return binarizeImpl(symbols.data(), symbols.size());
+}
+
+BinDecodeEntry Binarization::decodeLong(const BinString& bins, size_t pos) const {
+    const uint64_t key = reverseBins(bins.peek(pos, maxLen_), maxLen_);
+    const auto it = std::upper_bound(longKeys_.begin(), longKeys_.end(), key);
+    if (it == longKeys_.begin()) return BinDecodeEntry{0, 0};
+    const size_t i = static_cast<size_t>(it - longKeys_.begin()) - 1;
+    const uint32_t s = longCodes_[i];
+    const int len = codes_[s].len;
+    if ((key >> (maxLen_ - len)) != (longKeys_[i] >> (maxLen_ - len))) return BinDecodeEntry{0, 0};
+    return BinDecodeEntry{static_cast<uint16_t>(s), static_cast<uint8_t>(len)};
+}
+
+BinDecodeEntry Binarization::match(uint32_t code, int len) const {
+    if (len < 1 || len > maxLen_) return BinDecodeEntry{0, 0};
+    if (len <= peek_) {
+        const BinDecodeEntry e = table_[code];
+        return e.len == len ? e : BinDecodeEntry{0, 0};
+    }
+    const uint64_t key = uint64_t(reverseBins(code, len)) << (maxLen_ - len);
+    const auto it = std::lower_bound(longKeys_.begin(), longKeys_.end(), key);
+    if (it == longKeys_.end() || *it != key) return BinDecodeEntry{0, 0};
+    const uint32_t s = longCodes_[static_cast<size_t>(it - longKeys_.begin())];
+    if (codes_[s].len != len) return BinDecodeEntry{0, 0};
+    return BinDecodeEntry{static_cast<uint16_t>(s), static_cast<uint8_t>(len)};
+}
+
+size_t Binarization::debinarize(const BinString& bins, int* out, size_t capacity) const {
+    size_t n = 0;
+    size_t pos = 0;
+    while (pos < bins.size()) {
+        BinDecodeEntry e = table_[bins.peek(pos, peek_)];
+        if (e.len == 0 && !longCodes_.empty()) e = decodeLong(bins, pos);
+        if (e.len == 0) {
+            throw std::runtime_error(pos + static_cast<size_t>(maxLen_) > bins.size()
+                                     ? "debinarize: truncated codeword"
+                                     : "debinarize: invalid codeword");
+        }
+        if (pos + e.len > bins.size()) {
+            throw std::runtime_error("debinarize: truncated codeword");
+        }
+        if (n == capacity) {
+            throw std::runtime_error("debinarize: output buffer too small");
+        }
+        out[n++] = e.symbol;
+        pos += e.len;
+    }
+    return n;
+}
+
+std::vector<int> Binarization::debinarize(const BinString& bins) const {
+    // Every codeword takes at least one bin.
+    std::vector<int> out(bins.size());
+    out.resize(debinarize(bins, out.data(), out.size()));
+    return out;
+}
+
+namespace {
+    template <size_t A, int P>
+    Binarization fromStatic(const StaticBinarization<A, P>& b) {
+        return Binarization(std::vector<BinCode>(b.codes.begin(), b.codes.end()));
+    }
+
+    struct Registry {
+        std::mutex mutex;
+        std::deque<Binarization> entries; // deque: references survive growth
+    };
+
+    Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    const Binarization& builtin(BinarizationType type) {
+        static const Binarization good = fromStatic(GOOD_BINARIZATION);
+        static const Binarization bad  = fromStatic(BAD_BINARIZATION);
+        return type == BinarizationType::Good ? good : bad;
+    }
+
+    constexpr int BUILTIN_COUNT = 2;
+} // namespace
+
+int registerBinarization(Binarization b) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.entries.push_back(std::move(b));
+    return BUILTIN_COUNT + static_cast<int>(r.entries.size()) - 1;
+}
+
+const Binarization& binarization(int id) {
+    if (id == 0) return builtin(BinarizationType::Good);
+    if (id == 1) return builtin(BinarizationType::Bad);
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (id < BUILTIN_COUNT || static_cast<size_t>(id - BUILTIN_COUNT) >= r.entries.size()) {
+        throw std::runtime_error("binarization: unknown id");
+    }
+    return r.entries[static_cast<size_t>(id - BUILTIN_COUNT)];
+}
+
+const Binarization& binarization(BinarizationType type) {
+    return builtin(type);
+}
@@ -1,38 +1,35 @@
 #include "bitstream.hpp"
+#include <algorithm>
 #include <stdexcept>
 
 // ====================
 // BitWriter
 // ====================
 
-void BitWriter::writeBit(bool bit) {
-    // Pack bits LSB-first into currentByte_
-    currentByte_ |= (bit ? 1u : 0u) << bitPos_;
-    ++bitPos_;
-
-    // If we filled the byte, push it to the buffer and reset.
-    if (bitPos_ == 8) {
-        buffer_.push_back(currentByte_);
-        currentByte_ = 0;
-        bitPos_ = 0;
-    }
-}
-
-void BitWriter::writeBits(uint32_t value, int nBits) {
-    for (int i = 0; i < nBits; ++i) {
-        bool bit = (value >> i) & 1u; // LSB-first
-        writeBit(bit);
-    }
+void BitWriter::grow() {
+    buffer_.resize(std::max<size_t>(64, 2 * buffer_.size()));
 }
 
 std::vector<uint8_t> BitWriter::flush() {
     // If there are partially filled bits, push the last byte.
-    if (bitPos_ != 0) {
-        buffer_.push_back(currentByte_);
-        currentByte_ = 0;
-        bitPos_ = 0;
+    if (accBits_ != 0) {
+        if (bytes_ + 8 > buffer_.size()) grow();
+        buffer_[bytes_++] = static_cast<uint8_t>(acc_);
+        acc_ = 0;
+        accBits_ = 0;
     }
-    return buffer_;
+    buffer_.resize(bytes_);
+    std::vector<uint8_t> out;
+    out.swap(buffer_);
+    bytes_ = 0;
+    return out;
+}
+
+void BitWriter::reset(std::vector<uint8_t> buffer) {
+    buffer_.swap(buffer);
+    bytes_ = buffer_.size();
+    acc_ = 0;
+    accBits_ = 0;
 }
 
 // ====================
@@ -40,28 +37,30 @@ std::vector<uint8_t> BitWriter::flush() {
 // ====================
 
 BitReader::BitReader(const std::vector<uint8_t>& data)
-    : data_(data) {}
+    : data_(data.data()), size_(data.size()) {}
 
-bool BitReader::readBit() {
-    if (byteIndex_ >= data_.size()) {
-        throw std::runtime_error("BitReader: out of data");
-    }
+BitReader::BitReader(const uint8_t* data, size_t size)
+    : data_(data), size_(size) {}
 
-    bool bit = (data_[byteIndex_] >> bitPos_) & 1u;
-    ++bitPos_;
-    if (bitPos_ == 8) {
-        bitPos_ = 0;
-        ++byteIndex_;
+void BitReader::refill() {
+    if (bytePos_ + 8 <= size_) {
+        // Branch-free refill: load 8 bytes, keep as many as fit.
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) {
+            v |= static_cast<uint64_t>(data_[bytePos_ + i]) << (8 * i);
+        }
+        window_ |= v << windowBits_;
+        const int take = (63 - windowBits_) >> 3;
+        bytePos_    += static_cast<size_t>(take);
+        windowBits_ += 8 * take;
+    } else {
+        while (windowBits_ <= 56 && bytePos_ < size_) {
+            window_ |= static_cast<uint64_t>(data_[bytePos_++]) << windowBits_;
+            windowBits_ += 8;
+        }
     }
-    return bit;
 }
 
-uint32_t BitReader::readBits(int nBits) {
-    uint32_t v = 0;
-    for (int i = 0; i < nBits; ++i) {
-        if (readBit()) {
-            v |= (1u << i); // LSB-first
-        }
-    }
-    return v;
-}
\ No newline at end of file
+size_t BitReader::bitsLeft() const {
+    return static_cast<size_t>(windowBits_) + 8 * (size_ - bytePos_);
+}
@@ -0,0 +1,343 @@
+#include "block_codec.hpp"
+#include "byte_io.hpp"
+#include "cabac.hpp"
+#include "checksum.hpp"
+#include "mapped_file.hpp"
+#include "rans.hpp"
+#include "symbol_pack.hpp"
+#include "tans.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+    constexpr int RANS_BLOCK_LANES = 32;
+
+    constexpr uint8_t HEADER_MAGIC[4] = {'E', 'E', 'C', 'B'};
+    constexpr uint8_t FOOTER_MAGIC[4] = {'E', 'E', 'C', 'X'};
+    constexpr size_t  HEADER_SIZE      = 20; // magic, version, codec, reserved, blockSize, N
+    constexpr size_t  FOOTER_SIZE      = 24; // indexOffset, nBlocks, index checksum, magic
+    constexpr size_t  INDEX_ENTRY_SIZE = 24; // offset, compressed, raw, checksum
+
+    struct Container {
+        BlockCodec codec = BlockCodec::Rans;
+        uint32_t blockSize = 0;
+        uint64_t N = 0;
+        std::vector<BlockInfo> blocks;
+
+        size_t count() const { return blocks.size(); }
+    };
+
+    bool hasMagic(const uint8_t* p, const uint8_t (&magic)[4]) {
+        return std::equal(magic, magic + 4, p);
+    }
+
+    // Parse and validate header, footer and index. Payload checksums are
+    // left to the caller so random access only hashes the block it reads.
+    Container readContainer(const uint8_t* stream, size_t size) {
+        if (size < HEADER_SIZE + FOOTER_SIZE) {
+            throw std::runtime_error("decompressBlocks: stream too short");
+        }
+        if (!hasMagic(stream, HEADER_MAGIC)) {
+            throw std::runtime_error("decompressBlocks: bad magic");
+        }
+        if (!hasMagic(stream + size - 4, FOOTER_MAGIC)) {
+            throw std::runtime_error("decompressBlocks: missing footer (truncated stream)");
+        }
+
+        Container c;
+        size_t offset = 4;
+        if (stream[offset++] != BLOCK_CONTAINER_VERSION) {
+            throw std::runtime_error("decompressBlocks: unsupported container version");
+        }
+        const uint8_t codec = stream[offset++];
+        if (codec > static_cast<uint8_t>(BlockCodec::Raw)) {
+            throw std::runtime_error("decompressBlocks: unknown codec");
+        }
+        c.codec = static_cast<BlockCodec>(codec);
+        offset += 2; // reserved
+        c.blockSize = readU32LE(stream, size, offset);
+        c.N         = readU64LE(stream, size, offset);
+
+        size_t foot = size - FOOTER_SIZE;
+        const uint64_t indexOffset   = readU64LE(stream, size, foot);
+        const uint32_t nBlocks       = readU32LE(stream, size, foot);
+        const uint64_t indexChecksum = readU64LE(stream, size, foot);
+
+        const uint64_t indexEnd = size - FOOTER_SIZE;
+        if (indexOffset < HEADER_SIZE || indexOffset > indexEnd ||
+            uint64_t(nBlocks) * INDEX_ENTRY_SIZE != indexEnd - indexOffset) {
+            throw std::runtime_error("decompressBlocks: bad block index");
+        }
+        size_t pos = static_cast<size_t>(indexOffset);
+        if (xxhash64(stream + pos, static_cast<size_t>(indexEnd - indexOffset)) != indexChecksum) {
+            throw std::runtime_error("decompressBlocks: block index checksum mismatch");
+        }
+
+        c.blocks.resize(nBlocks);
+        uint64_t rawTotal = 0;
+        for (BlockInfo& b : c.blocks) {
+            b.offset         = readU64LE(stream, size, pos);
+            b.compressedSize = readU32LE(stream, size, pos);
+            b.rawSize        = readU32LE(stream, size, pos);
+            b.checksum       = readU64LE(stream, size, pos);
+            b.rawOffset      = rawTotal;
+            if (b.offset < HEADER_SIZE || b.offset > indexOffset ||
+                b.compressedSize > indexOffset - b.offset) {
+                throw std::runtime_error("decompressBlocks: block outside payload area");
+            }
+            rawTotal += b.rawSize;
+        }
+        if (rawTotal != c.N) {
+            throw std::runtime_error("decompressBlocks: block sizes do not add up to N");
+        }
+        return c;
+    }
+
+    std::vector<uint8_t> packRaw(const uint8_t* symbols, size_t n) {
+        return packSymbols2(symbols, n);
+    }
+
+    std::vector<uint8_t> packRaw(const int* symbols, size_t n) {
+        std::vector<uint8_t> packed(packedSize2(n));
+        for (size_t i = 0; i < n; ++i) {
+            const unsigned s = static_cast<unsigned>(symbols[i]);
+            if (s > 3u) {
+                throw std::runtime_error("compressBlocks: symbol out of range (0..3)");
+            }
+            packed[i >> 2] = static_cast<uint8_t>(packed[i >> 2] | (s << (2 * (i & 3))));
+        }
+        return packed;
+    }
+
+    // Code symbols[0, n) in place; blocks are never copied out of the input.
+    template <class Sym>
+    std::vector<uint8_t> encodeOne(const Sym* symbols, size_t n, BlockCodec codec) {
+        if (codec == BlockCodec::Cabac) {
+            std::vector<uint8_t> out;
+            cabacEncodeSymbols(symbols, n, BinarizationType::Good,
+                               CabacContextMode::BinIndex, out);
+            return out;
+        }
+        if (codec == BlockCodec::Tans) {
+            return tansEncode(symbols, n);
+        }
+        if (codec == BlockCodec::Raw) {
+            return packRaw(symbols, n);
+        }
+        return ransEncodeSimd(symbols, n, RANS_BLOCK_LANES);
+    }
+
+    void unpackRaw(const uint8_t* packed, size_t n, uint8_t* out) {
+        unpackSymbols2(packed, n, out);
+    }
+
+    void unpackRaw(const uint8_t* packed, size_t n, int* out) {
+        const Packed2View view{packed};
+        for (size_t i = 0; i < n; ++i) out[i] = view[i];
+    }
+
+    bool checksumOk(const uint8_t* stream, const BlockInfo& b) {
+        return xxhash64(stream + b.offset, b.compressedSize) == b.checksum;
+    }
+
+    // Verify block i, then decode it straight from the stream into
+    // out[0, rawSize).
+    template <class Out>
+    void decodeOne(const uint8_t* stream, const Container& c, size_t i, Out* out) {
+        const BlockInfo& b = c.blocks[i];
+        if (!checksumOk(stream, b)) {
+            throw std::runtime_error("decompressBlocks: block checksum mismatch");
+        }
+        const uint8_t* p = stream + b.offset;
+        const size_t n = b.compressedSize;
+        const size_t want = b.rawSize;
+
+        size_t got = 0;
+        if (c.codec == BlockCodec::Cabac) {
+            if (cabacDecodedSize(p, n) != want) {
+                throw std::runtime_error("decompressBlocks: block size mismatch");
+            }
+            got = cabacDecodeSymbols(p, n, out, want);
+        } else if (c.codec == BlockCodec::Raw) {
+            if (n != packedSize2(want)) {
+                throw std::runtime_error("decompressBlocks: block size mismatch");
+            }
+            unpackRaw(p, want, out);
+            got = want;
+        } else {
+            if (n < 4 || ransDecodedSize(p, n) != want) {
+                throw std::runtime_error("decompressBlocks: block size mismatch");
+            }
+            got = (c.codec == BlockCodec::Tans) ? tansDecode(p, n, out, want)
+                                                : ransDecodeSimd(p, n, out, want);
+        }
+        if (got != want) {
+            throw std::runtime_error("decompressBlocks: block size mismatch");
+        }
+    }
+} // namespace
+
+namespace {
+    template <class Sym>
+    std::vector<uint8_t> compressImpl(const Sym* symbols, size_t N,
+                                      const BlockOptions& opt)
+    {
+        if (opt.blockSize == 0 || opt.blockSize > UINT32_MAX) {
+            throw std::runtime_error("compressBlocks: bad block size");
+        }
+
+        const size_t nBlocks = (N + opt.blockSize - 1) / opt.blockSize;
+        if (nBlocks > UINT32_MAX) {
+            throw std::runtime_error("compressBlocks: too many blocks");
+        }
+        std::vector<std::vector<uint8_t>> packed(nBlocks);
+        std::vector<uint64_t> checksums(nBlocks);
+
+        parallelForThreads(nBlocks, opt.threads, [&](size_t i) {
+            const size_t lo = i * opt.blockSize;
+            const size_t hi = std::min(N, lo + opt.blockSize);
+            packed[i] = encodeOne(symbols + lo, hi - lo, opt.codec);
+            if (packed[i].size() > UINT32_MAX) {
+                throw std::runtime_error("compressBlocks: block too large");
+            }
+            checksums[i] = xxhash64(packed[i].data(), packed[i].size());
+        });
+
+        size_t payload = 0;
+        for (const auto& p : packed) payload += p.size();
+
+        std::vector<uint8_t> out;
+        out.reserve(HEADER_SIZE + payload + nBlocks * INDEX_ENTRY_SIZE + FOOTER_SIZE);
+        out.insert(out.end(), HEADER_MAGIC, HEADER_MAGIC + 4);
+        out.push_back(BLOCK_CONTAINER_VERSION);
+        out.push_back(static_cast<uint8_t>(opt.codec));
+        writeU16LE(out, 0); // reserved
+        writeU32LE(out, static_cast<uint32_t>(opt.blockSize));
+        writeU64LE(out, N);
+
+        for (const auto& p : packed) out.insert(out.end(), p.begin(), p.end());
+
+        const size_t indexOffset = out.size();
+        uint64_t offset = HEADER_SIZE;
+        for (size_t i = 0; i < nBlocks; ++i) {
+            const size_t lo = i * opt.blockSize;
+            writeU64LE(out, offset);
+            writeU32LE(out, static_cast<uint32_t>(packed[i].size()));
+            writeU32LE(out, static_cast<uint32_t>(std::min(N, lo + opt.blockSize) - lo));
+            writeU64LE(out, checksums[i]);
+            offset += packed[i].size();
+        }
+        const uint64_t indexChecksum = xxhash64(out.data() + indexOffset,
+                                                out.size() - indexOffset);
+
+        writeU64LE(out, indexOffset);
+        writeU32LE(out, static_cast<uint32_t>(nBlocks));
+        writeU64LE(out, indexChecksum);
+        out.insert(out.end(), FOOTER_MAGIC, FOOTER_MAGIC + 4);
+        return out;
+    }
+} // namespace
+
+std::vector<uint8_t> compressBlocks(const std::vector<int>& symbols,
+                                    const BlockOptions& opt)
+{
+    return compressImpl(symbols.data(), symbols.size(), opt);
+}
+
+std::vector<uint8_t> compressBlocks(const std::vector<uint8_t>& symbols,
+                                    const BlockOptions& opt)
+{
+    return compressBlocks(symbols.data(), symbols.size(), opt);
+}
+
+std::vector<uint8_t> compressBlocks(const uint8_t* symbols, size_t n,
+                                    const BlockOptions& opt)
+{
+    return compressImpl(symbols, n, opt);
+}
+
+std::vector<int> decompressBlocks(const std::vector<uint8_t>& stream,
+                                  unsigned threads)
+{
+    std::vector<int> out(decompressedSize(stream.data(), stream.size()));
+    decompressBlocks(stream.data(), stream.size(), out.data(), out.size(), threads);
+    return out;
+}
+
+size_t decompressedSize(const uint8_t* stream, size_t size) {
+    return static_cast<size_t>(readContainer(stream, size).N);
+}
+
+namespace {
+    template <class Out>
+    size_t decompressImpl(const uint8_t* stream, size_t size, Out* out,
+                          size_t capacity, unsigned threads)
+    {
+        const Container c = readContainer(stream, size);
+        if (c.N > capacity) {
+            throw std::runtime_error("decompressBlocks: output buffer too small");
+        }
+        parallelForThreads(c.count(), threads, [&](size_t i) {
+            decodeOne(stream, c, i, out + c.blocks[i].rawOffset);
+        });
+        return static_cast<size_t>(c.N);
+    }
+} // namespace
+
+size_t decompressBlocks(const uint8_t* stream, size_t size, int* out,
+                        size_t capacity, unsigned threads)
+{
+    return decompressImpl(stream, size, out, capacity, threads);
+}
+
+size_t decompressBlocks(const uint8_t* stream, size_t size, uint8_t* out,
+                        size_t capacity, unsigned threads)
+{
+    return decompressImpl(stream, size, out, capacity, threads);
+}
+
+std::vector<int> decompressFile(const std::string& path, unsigned threads) {
+    const MappedFile file(path);
+    std::vector<int> out(decompressedSize(file.data(), file.size()));
+    decompressBlocks(file.data(), file.size(), out.data(), out.size(), threads);
+    return out;
+}
+
+BlockCodec blockCodec(const uint8_t* stream, size_t size) {
+    return readContainer(stream, size).codec;
+}
+
+std::vector<BlockInfo> blockIndex(const uint8_t* stream, size_t size) {
+    return readContainer(stream, size).blocks;
+}
+
+bool verifyBlocks(const uint8_t* stream, size_t size) {
+    try {
+        const Container c = readContainer(stream, size);
+        for (const BlockInfo& b : c.blocks) {
+            if (!checksumOk(stream, b)) return false;
+        }
+        return true;
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+size_t blockCount(const std::vector<uint8_t>& stream) {
+    return readContainer(stream.data(), stream.size()).count();
+}
+
+std::vector<int> decompressBlock(const std::vector<uint8_t>& stream,
+                                 size_t index)
+{
+    const Container c = readContainer(stream.data(), stream.size());
+    if (index >= c.count()) {
+        throw std::runtime_error("decompressBlock: block index out of range");
+    }
+    std::vector<int> out(c.blocks[index].rawSize);
+    decodeOne(stream.data(), c, index, out.data());
+    return out;
+}
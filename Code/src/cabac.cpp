@@ -1,8 +1,12 @@
 #include "cabac.hpp"
 #include "bitstream.hpp"
+#include "byte_io.hpp"
+#include "cabac_tables.hpp"
+#include "codec_trace.hpp"
 
 #include <array>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 // ============================
@@ -23,49 +27,732 @@
 //   2 -> 10
 //   3 -> 0
 
-static const std::array<std::vector<int>, 4> GOOD_TABLE = {
-    std::vector<int>{0},              // 0
-    std::vector<int>{1, 0},           // 1
-    std::vector<int>{1, 1, 0},        // 2
-    std::vector<int>{1, 1, 1, 0}      // 3
-};
+static_assert(CABAC_MAX_CONTEXTS <= static_cast<int>(CODEC_TRACE_CONTEXTS),
+              "trace counts fewer contexts than the coder uses");
 
-static const std::array<std::vector<int>, 4> BAD_TABLE = {
-    std::vector<int>{1, 1, 1, 0},     // 0
-    std::vector<int>{1, 1, 0},        // 1
-    std::vector<int>{1, 0},           // 2
-    std::vector<int>{0}               // 3
-};
+// Both tables are generated at compile time (binarization.hpp). Any
+// other value, say one cast from a corrupt stream, is rejected.
+static const StaticBinarization<4, 4>& unaryBinarization(BinarizationType type) {
+    if (type == BinarizationType::Good) return GOOD_BINARIZATION;
+    if (type == BinarizationType::Bad) return BAD_BINARIZATION;
+    throw std::runtime_error("binarization: unknown type");
+}
 
-std::vector<int> binarizeSymbol(int symbol, BinarizationType type) {
+static const BinCode* codeTable(BinarizationType type) {
+    return unaryBinarization(type).codes.data();
+}
+
+BinCode binCode(int symbol, BinarizationType type) {
     if (symbol < 0 || symbol > 3) {
         throw std::runtime_error("symbol out of range (0..3)");
     }
+    return codeTable(type)[symbol];
+}
 
-    if (type == BinarizationType::Good) {
-        return GOOD_TABLE[static_cast<size_t>(symbol)];
-    } else {
-        return BAD_TABLE[static_cast<size_t>(symbol)];
-    }
+std::vector<int> binarizeSymbol(int symbol, BinarizationType type) {
+    const BinCode c = binCode(symbol, type);
+    std::vector<int> bits(static_cast<size_t>(c.len));
+    for (int k = 0; k < c.len; ++k) bits[static_cast<size_t>(k)] = (c.code >> k) & 1u;
+    return bits;
 }
 
 std::vector<int> binarizeSequence(const std::vector<int>& symbols,
                                   BinarizationType type)
 {
+    CODEC_STAGE(Binarize);
     std::vector<int> bits;
-    bits.reserve(symbols.size() * 4); // rough upper bound
+    bits.reserve(symbols.size() * 4); // longest codeword is 4 bins
 
     for (int s : symbols) {
-        auto b = binarizeSymbol(s, type);
-        bits.insert(bits.end(), b.begin(), b.end());
+        const BinCode c = binCode(s, type);
+        for (int k = 0; k < c.len; ++k) bits.push_back((c.code >> k) & 1u);
     }
     return bits;
 }
 
+namespace {
+    template <class Sym>
+    void binarizePacked(const Sym* symbols, size_t n, BinarizationType type,
+                        BinString& bins)
+    {
+        CODEC_STAGE(Binarize);
+        const BinCode* table = codeTable(type);
+
+        bins.clear();
+        bins.reserve(n * 4); // longest codeword is 4 bins
+
+        for (size_t i = 0; i < n; ++i) {
+            const unsigned s = static_cast<unsigned>(symbols[i]);
+            if (s > 3u) {
+                throw std::runtime_error("symbol out of range (0..3)");
+            }
+            bins.append(table[s].code, table[s].len);
+        }
+    }
+
+    // One 4-bin peek resolves each codeword; bins past the end read as
+    // zero, so a cut-off codeword shows up as running past size().
+    // emit(symbol) is called once per decoded codeword.
+    template <class Emit>
+    void debinarize(const BinString& bins, BinarizationType type, Emit emit) {
+        CODEC_STAGE(Binarize);
+        const BinDecodeEntry* table = unaryBinarization(type).decode.data();
+        size_t i = 0;
+        while (i < bins.size()) {
+            const BinDecodeEntry e = table[bins.peek(i, 4)];
+            if (e.len == 0) {
+                throw std::runtime_error(i + 4 > bins.size()
+                                         ? "debinarizeSequence: truncated codeword"
+                                         : "debinarizeSequence: invalid codeword");
+            }
+            i += e.len;
+            if (i > bins.size()) {
+                throw std::runtime_error("debinarizeSequence: truncated codeword");
+            }
+            emit(static_cast<int>(e.symbol));
+        }
+    }
+} // namespace
+
+BinString binarizeSequencePacked(const std::vector<int>& symbols,
+                                 BinarizationType type)
+{
+    BinString bins;
+    binarizePacked(symbols.data(), symbols.size(), type, bins);
+    return bins;
+}
+
+BinString binarizeSequencePacked(const std::vector<uint8_t>& symbols,
+                                 BinarizationType type)
+{
+    BinString bins;
+    binarizePacked(symbols.data(), symbols.size(), type, bins);
+    return bins;
+}
+
+void binarizeSequencePacked(const int* symbols, size_t n, BinarizationType type,
+                            BinString& out)
+{
+    binarizePacked(symbols, n, type, out);
+}
+
+void binarizeSequencePacked(const uint8_t* symbols, size_t n, BinarizationType type,
+                            BinString& out)
+{
+    binarizePacked(symbols, n, type, out);
+}
+
+std::vector<int> debinarizeSequence(const BinString& bins,
+                                    BinarizationType type)
+{
+    std::vector<int> symbols;
+    symbols.reserve(bins.size());
+    debinarize(bins, type, [&](int s) { symbols.push_back(s); });
+    return symbols;
+}
+
+size_t debinarizeSequence(const BinString& bins, BinarizationType type,
+                          uint8_t* out, size_t capacity)
+{
+    size_t n = 0;
+    debinarize(bins, type, [&](int s) {
+        if (n == capacity) {
+            throw std::runtime_error("debinarizeSequence: output buffer too small");
+        }
+        out[n++] = static_cast<uint8_t>(s);
+    });
+    return n;
+}
+
+std::vector<unsigned char> packBitsToBytes(const BinString& bins) {
+    CODEC_STAGE(Pack);
+    // The packed layout already is the LSB-first byte stream.
+    std::vector<unsigned char> out((bins.size() + 7) / 8);
+    const uint64_t* w = bins.words();
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = static_cast<unsigned char>(w[i >> 3] >> (8 * (i & 7)));
+    }
+    return out;
+}
+
 std::vector<unsigned char> packBitsToBytes(const std::vector<int>& bits) {
+    CODEC_STAGE(Pack);
     BitWriter bw;
-    for (int b : bits) {
-        bw.writeBit(b != 0);
+    size_t i = 0;
+    for (; i + 32 <= bits.size(); i += 32) {
+        uint32_t word = 0;
+        for (int k = 0; k < 32; ++k) {
+            word |= static_cast<uint32_t>(bits[i + k] != 0) << k;
+        }
+        bw.writeBits(word, 32);
+    }
+    for (; i < bits.size(); ++i) {
+        bw.writeBit(bits[i] != 0);
     }
     return bw.flush();
-}
\ No newline at end of file
+}
+
+// ============================
+// CABAC arithmetic encoder
+// ============================
+
+void CabacEncoder::putByte() {
+    if (queue_ < 0) return;
+
+    uint32_t out = low_ >> (queue_ + 10);
+    low_ &= (0x400u << queue_) - 1;
+    queue_ -= 8;
+
+    // A 0xFF byte may still absorb a carry; hold it back.
+    if ((out & 0xFFu) == 0xFFu) {
+        ++outstanding_;
+        return;
+    }
+
+    uint32_t carry = out >> 8;
+    if (out_.size() > start_) out_.back() = static_cast<uint8_t>(out_.back() + carry);
+    for (; outstanding_ > 0; --outstanding_) {
+        out_.push_back(static_cast<uint8_t>(0xFFu + carry));
+    }
+    out_.push_back(static_cast<uint8_t>(out));
+}
+
+void CabacEncoder::encodeDecision(CabacContext& ctx, int bin) {
+    const CabacTransition& t = cabacTransTab[ctx.packed];
+    uint32_t rLPS = t.rangeLPS[(range_ >> 6) & 3];
+    range_ -= rLPS;
+
+    const int b = bin != 0;
+    if (b != ctx.mps()) {
+        low_  += range_;
+        range_ = rLPS;
+    }
+    CODEC_TRACE_ONLY(++tally_.contextBins; tally_.lps += b != ctx.mps();)
+    ctx.packed = t.next[b];
+
+    int shift = cabacRenormShift[range_ >> 3];
+    range_ <<= shift;
+    low_   <<= shift;
+    queue_  += shift;
+    putByte();
+}
+
+void CabacEncoder::encodeBypass(int bin) {
+    CODEC_TRACE_ONLY(++tally_.bypassBins;)
+    low_ = (low_ << 1) + (range_ & (0u - static_cast<uint32_t>(bin != 0)));
+    queue_ += 1;
+    putByte();
+}
+
+void CabacEncoder::encodeBypassBits(uint32_t value, int n) {
+    CODEC_TRACE_ONLY(tally_.bypassBins += static_cast<uint64_t>(n);)
+    // low_ has room for one byte plus carry beyond the 10-bit window, so
+    // take 8 bins at a time and emit a byte after each chunk.
+    while (n > 0) {
+        const int k = n < 8 ? n : 8;
+        n -= k;
+        low_ = (low_ << k) + ((value >> n) & ((1u << k) - 1)) * range_;
+        queue_ += k;
+        putByte();
+    }
+}
+
+std::vector<uint8_t> CabacEncoder::finish() {
+    // Any value in [low, low + range) identifies the codeword; range >= 256,
+    // so pick the one with eight trailing zero bits.
+    low_ = (low_ + 0xFFu) & ~0xFFu;
+
+    // Drain every pending bit of low_, then settle held-back 0xFF bytes.
+    for (int i = 0; i < 3; ++i) {
+        low_  <<= 8;
+        queue_ += 8;
+        putByte();
+    }
+    for (; outstanding_ > 0; --outstanding_) out_.push_back(0xFFu);
+
+    // The decoder reads zeros past the end, so that zero byte need not be
+    // stored. Any others stay: the length bounds the bin count
+    // (cabacBinCountFits).
+    if (out_.size() > start_ && out_.back() == 0) out_.pop_back();
+    CODEC_COUNT(CabacBytesOut, out_.size() - start_);
+
+    std::vector<uint8_t> out;
+    out.swap(out_);
+    reset({});
+    return out;
+}
+
+void CabacEncoder::reset(std::vector<uint8_t> buffer) {
+    out_.swap(buffer);
+    start_ = out_.size();
+    low_ = 0;
+    range_ = 510;
+    queue_ = -9;
+    outstanding_ = 0;
+}
+
+// ============================
+// CABAC arithmetic decoder
+// ============================
+
+CabacDecoder::CabacDecoder(const uint8_t* data, size_t size)
+    : data_(data), size_(size)
+{
+    refill();
+}
+
+void CabacDecoder::refill() {
+    // Keep at least 48 lookahead bits; value_ never exceeds 64 bits.
+    while (avail_ < 48) {
+        uint8_t b = (pos_ < size_) ? data_[pos_] : 0;
+        ++pos_;
+        value_ = (value_ << 8) | b;
+        avail_ += 8;
+    }
+}
+
+int CabacDecoder::decodeDecision(CabacContext& ctx) {
+    const CabacTransition& t = cabacTransTab[ctx.packed];
+    uint32_t rLPS = t.rangeLPS[(range_ >> 6) & 3];
+    range_ -= rLPS;
+    uint64_t scaledRange = static_cast<uint64_t>(range_) << avail_;
+
+    int bin = ctx.mps();
+    if (value_ >= scaledRange) {
+        value_ -= scaledRange;
+        range_  = rLPS;
+        bin ^= 1;
+    }
+    CODEC_TRACE_ONLY(++tally_.contextBins; tally_.lps += bin != ctx.mps();)
+    ctx.packed = t.next[bin];
+
+    // Renormalizing only moves the offset/lookahead boundary.
+    int shift = cabacRenormShift[range_ >> 3];
+    range_ <<= shift;
+    avail_  -= shift;
+    if (avail_ < 16) refill();
+    return bin;
+}
+
+int CabacDecoder::decodeBypass() {
+    CODEC_TRACE_ONLY(++tally_.bypassBins;)
+    --avail_;
+    uint64_t scaledRange = static_cast<uint64_t>(range_) << avail_;
+    int bin = value_ >= scaledRange;
+    value_ -= scaledRange & (0ull - static_cast<uint64_t>(bin));
+    if (avail_ < 16) refill();
+    return bin;
+}
+
+uint32_t CabacDecoder::decodeBypassBits(int n) {
+    CODEC_TRACE_ONLY(tally_.bypassBins += static_cast<uint64_t>(n);)
+    // k bypass bins are the k-bit quotient of the window by range; at
+    // least 16 lookahead bits are always available.
+    uint32_t value = 0;
+    while (n > 0) {
+        const int k = n < 16 ? n : 16;
+        n -= k;
+        avail_ -= k;
+        const uint32_t q = static_cast<uint32_t>(value_ >> avail_) / range_;
+        value_ -= static_cast<uint64_t>(q * range_) << avail_;
+        value = (value << k) | q;
+        if (avail_ < 16) refill();
+    }
+    return value;
+}
+
+// ============================
+// Bin-string front end
+// ============================
+
+namespace {
+    // Frame the codeword with nBins (u32 LE).
+    std::vector<uint8_t> frameBins(uint32_t nBins, const std::vector<uint8_t>& payload) {
+        std::vector<uint8_t> out;
+        out.reserve(4 + payload.size());
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<uint8_t>((nBins >> (8 * i)) & 0xFFu));
+        }
+        out.insert(out.end(), payload.begin(), payload.end());
+        return out;
+    }
+
+    uint32_t readBinCount(const uint8_t* stream, size_t size) {
+        if (size < 4) {
+            throw std::runtime_error("arithDecodeBits: stream too short");
+        }
+        uint32_t nBins = 0;
+        for (int i = 0; i < 4; ++i) {
+            nBins |= static_cast<uint32_t>(stream[i]) << (8 * i);
+        }
+        if (!cabacBinCountFits(nBins, size - 4)) {
+            throw std::runtime_error("arithDecodeBits: bin count exceeds the payload");
+        }
+        return nBins;
+    }
+} // namespace
+
+std::vector<uint8_t> arithEncodeBits(const std::vector<int>& bits) {
+    CODEC_STAGE(Encode);
+    CabacEncoder enc;
+    CabacContext ctx;
+    for (int b : bits) {
+        enc.encodeDecision(ctx, b != 0);
+    }
+    return frameBins(static_cast<uint32_t>(bits.size()), enc.finish());
+}
+
+std::vector<uint8_t> arithEncodeBits(const BinString& bins) {
+    CODEC_STAGE(Encode);
+    CabacEncoder enc;
+    CabacContext ctx;
+    const uint64_t* w = bins.words();
+    for (size_t i = 0; i < bins.size(); ++i) {
+        enc.encodeDecision(ctx, static_cast<int>((w[i >> 6] >> (i & 63)) & 1u));
+    }
+    return frameBins(static_cast<uint32_t>(bins.size()), enc.finish());
+}
+
+std::vector<int> arithDecodeBits(const std::vector<uint8_t>& stream) {
+    CODEC_STAGE(Decode);
+    const uint32_t nBins = readBinCount(stream.data(), stream.size());
+
+    CabacDecoder dec(stream.data() + 4, stream.size() - 4);
+    CabacContext ctx;
+    std::vector<int> bits(nBins);
+    for (uint32_t i = 0; i < nBins; ++i) {
+        bits[i] = dec.decodeDecision(ctx);
+    }
+    return bits;
+}
+
+BinString arithDecodeBins(const std::vector<uint8_t>& stream) {
+    return arithDecodeBins(stream.data(), stream.size());
+}
+
+BinString arithDecodeBins(const uint8_t* stream, size_t size) {
+    BinString bins;
+    arithDecodeBins(stream, size, bins);
+    return bins;
+}
+
+void arithDecodeBins(const uint8_t* stream, size_t size, BinString& bins) {
+    CODEC_STAGE(Decode);
+    const uint32_t nBins = readBinCount(stream, size);
+
+    CabacDecoder dec(stream + 4, size - 4);
+    CabacContext ctx;
+    bins.clear();
+    bins.reserve(nBins);
+    for (uint32_t i = 0; i < nBins; ++i) {
+        bins.push(dec.decodeDecision(ctx));
+    }
+}
+
+// ============================
+// Context-modeled symbol coder
+// ============================
+
+namespace {
+    constexpr size_t SYMBOL_HEADER_SIZE = 6;
+
+    // Registry ids 0 and 1 are the unary Good / Bad binarizations, which
+    // keep their dedicated decoder.
+    constexpr int UNARY_BINARIZATIONS = 2;
+
+    struct SymbolHeader {
+        uint32_t n;
+        int binarizationId;
+        CabacContextMode mode;
+    };
+
+    // Throws on an id that is neither built in nor registered.
+    SymbolHeader readSymbolHeader(const uint8_t* stream, size_t size) {
+        if (size < SYMBOL_HEADER_SIZE) {
+            throw std::runtime_error("cabacDecodeSymbols: stream too short");
+        }
+        SymbolHeader h;
+        h.n = readBinCount(stream, size);
+        if (stream[5] > static_cast<uint8_t>(CabacContextMode::BinIndexPrevSymbol)) {
+            throw std::runtime_error("cabacDecodeSymbols: unknown context mode");
+        }
+        h.binarizationId = stream[4];
+        h.mode = static_cast<CabacContextMode>(stream[5]);
+        if (h.binarizationId >= UNARY_BINARIZATIONS) binarization(h.binarizationId);
+        return h;
+    }
+
+    // Codewords longer than four bins and alphabets larger than four
+    // share the last bin-position and previous-symbol contexts.
+    inline int symbolContext(CabacContextMode mode, int binIdx, unsigned prev) {
+        return cabacContextIndex(mode, binIdx < 3 ? binIdx : 3,
+                                 prev < 3u ? static_cast<int>(prev) : 3);
+    }
+
+    // The codeword is appended to buffer.
+    template <class Sym>
+    std::vector<uint8_t> encodeRun(const Sym* symbols, size_t n,
+                                   BinarizationType type, CabacContextMode mode,
+                                   std::vector<uint8_t> buffer = {})
+    {
+        const BinCode* table = codeTable(type);
+
+        CODEC_STAGE(Encode);
+        CODEC_TRACE_ONLY(CodecTally tally;)
+        CabacEncoder enc;
+        enc.reset(std::move(buffer));
+        std::array<CabacContext, CABAC_MAX_CONTEXTS> ctx{};
+        int prev = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const unsigned s = static_cast<unsigned>(symbols[i]);
+            if (s > 3u) {
+                throw std::runtime_error("cabacEncodeSymbols: symbol out of range (0..3)");
+            }
+            const BinCode c = table[s];
+            for (int k = 0; k < c.len; ++k) {
+                const int ci = cabacContextIndex(mode, k, prev);
+                CODEC_TRACE_ONLY(++tally.byContext[static_cast<size_t>(ci)];)
+                enc.encodeDecision(ctx[ci], static_cast<int>((c.code >> k) & 1u));
+            }
+            prev = static_cast<int>(s);
+        }
+        return enc.finish();
+    }
+
+    // Both binarizations are unary: decode 1 bins up to the terminating
+    // 0, each in the context of its position.
+    template <class Out>
+    void decodeRun(const uint8_t* data, size_t size, BinarizationType type,
+                   CabacContextMode mode, Out* out, size_t n)
+    {
+        const bool reversed = &unaryBinarization(type) == &BAD_BINARIZATION;
+
+        CODEC_STAGE(Decode);
+        CODEC_TRACE_ONLY(CodecTally tally;)
+        CabacDecoder dec(data, size);
+        std::array<CabacContext, CABAC_MAX_CONTEXTS> ctx{};
+        int prev = 0;
+        for (size_t i = 0; i < n; ++i) {
+            int ones = 0;
+            while (ones < 3) {
+                const int ci = cabacContextIndex(mode, ones, prev);
+                CODEC_TRACE_ONLY(++tally.byContext[static_cast<size_t>(ci)];)
+                if (!dec.decodeDecision(ctx[ci])) break;
+                ++ones;
+            }
+            if (ones == 3) {
+                const int ci = cabacContextIndex(mode, 3, prev);
+                CODEC_TRACE_ONLY(++tally.byContext[static_cast<size_t>(ci)];)
+                if (dec.decodeDecision(ctx[ci])) {
+                    throw std::runtime_error("cabacDecodeSymbols: invalid codeword");
+                }
+            }
+            const int s = reversed ? 3 - ones : ones;
+            out[i] = static_cast<Out>(s);
+            prev = s;
+        }
+    }
+
+    // Any binarization, contexts as in encodeRun.
+    template <class Sym>
+    std::vector<uint8_t> encodeRunWith(const Sym* symbols, size_t n,
+                                       const Binarization& b, CabacContextMode mode,
+                                       std::vector<uint8_t> buffer)
+    {
+        const std::vector<BinCode>& codes = b.codes();
+
+        CODEC_STAGE(Encode);
+        CODEC_TRACE_ONLY(CodecTally tally;)
+        CabacEncoder enc;
+        enc.reset(std::move(buffer));
+        std::array<CabacContext, CABAC_MAX_CONTEXTS> ctx{};
+        unsigned prev = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const unsigned s = static_cast<unsigned>(symbols[i]);
+            if (s >= codes.size()) {
+                throw std::runtime_error("cabacEncodeSymbols: symbol out of range");
+            }
+            const BinCode c = codes[s];
+            for (int k = 0; k < c.len; ++k) {
+                const int ci = symbolContext(mode, k, prev);
+                CODEC_TRACE_ONLY(++tally.byContext[static_cast<size_t>(ci)];)
+                enc.encodeDecision(ctx[ci], static_cast<int>((c.code >> k) & 1u));
+            }
+            prev = s;
+        }
+        return enc.finish();
+    }
+
+    // Bins are decoded one at a time until they spell a codeword.
+    template <class Out>
+    void decodeRunWith(const uint8_t* data, size_t size, const Binarization& b,
+                       CabacContextMode mode, Out* out, size_t n)
+    {
+        if (sizeof(Out) == 1 && b.alphabetSize() > 256) {
+            throw std::runtime_error("cabacDecodeSymbols: alphabet exceeds uint8_t");
+        }
+
+        CODEC_STAGE(Decode);
+        CODEC_TRACE_ONLY(CodecTally tally;)
+        CabacDecoder dec(data, size);
+        std::array<CabacContext, CABAC_MAX_CONTEXTS> ctx{};
+        unsigned prev = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t code = 0;
+            int len = 0;
+            BinDecodeEntry e{0, 0};
+            while (e.len == 0) {
+                if (len == b.maxLength()) {
+                    throw std::runtime_error("cabacDecodeSymbols: invalid codeword");
+                }
+                const int ci = symbolContext(mode, len, prev);
+                CODEC_TRACE_ONLY(++tally.byContext[static_cast<size_t>(ci)];)
+                code |= static_cast<uint32_t>(dec.decodeDecision(ctx[ci])) << len;
+                e = b.match(code, ++len);
+            }
+            out[i] = static_cast<Out>(e.symbol);
+            prev = e.symbol;
+        }
+    }
+
+    // The header goes first and the coder appends behind it, so the
+    // stream is built in place in out's storage.
+    template <class Sym>
+    void encodeSymbols(const Sym* symbols, size_t n, int binarizationId,
+                       CabacContextMode mode, std::vector<uint8_t>& out)
+    {
+        if (n > UINT32_MAX) {
+            throw std::runtime_error("cabacEncodeSymbols: too many symbols");
+        }
+        if (binarizationId < 0 || binarizationId > 255) {
+            throw std::runtime_error("cabacEncodeSymbols: binarization id above 255");
+        }
+        if (mode > CabacContextMode::BinIndexPrevSymbol) {
+            throw std::runtime_error("cabacEncodeSymbols: unknown context mode");
+        }
+        const Binarization* b = binarizationId < UNARY_BINARIZATIONS
+                              ? nullptr : &binarization(binarizationId);
+        out.clear();
+        writeU32LE(out, static_cast<uint32_t>(n));
+        out.push_back(static_cast<uint8_t>(binarizationId));
+        out.push_back(static_cast<uint8_t>(mode));
+        if (b == nullptr) {
+            const auto type = static_cast<BinarizationType>(binarizationId);
+            out = encodeRun(symbols, n, type, mode, std::move(out));
+        } else {
+            out = encodeRunWith(symbols, n, *b, mode, std::move(out));
+        }
+    }
+
+    template <class Sym>
+    void encodeSymbols(const Sym* symbols, size_t n, BinarizationType type,
+                       CabacContextMode mode, std::vector<uint8_t>& out)
+    {
+        unaryBinarization(type); // an unknown value must not pass as a registry id
+        encodeSymbols(symbols, n, static_cast<int>(type), mode, out);
+    }
+
+    template <class Out>
+    size_t decodeSymbols(const uint8_t* stream, size_t size, Out* out, size_t capacity) {
+        const SymbolHeader h = readSymbolHeader(stream, size);
+        if (h.n > capacity) {
+            throw std::runtime_error("cabacDecodeSymbols: output buffer too small");
+        }
+        const uint8_t* data = stream + SYMBOL_HEADER_SIZE;
+        const size_t dataSize = size - SYMBOL_HEADER_SIZE;
+        if (h.binarizationId < UNARY_BINARIZATIONS) {
+            const auto type = static_cast<BinarizationType>(h.binarizationId);
+            decodeRun(data, dataSize, type, h.mode, out, h.n);
+        } else {
+            const Binarization& b = binarization(h.binarizationId);
+            decodeRunWith(data, dataSize, b, h.mode, out, h.n);
+        }
+        return h.n;
+    }
+} // namespace
+
+std::vector<uint8_t> cabacEncodeSymbols(const std::vector<int>& symbols,
+                                        BinarizationType type, CabacContextMode mode)
+{
+    std::vector<uint8_t> out;
+    encodeSymbols(symbols.data(), symbols.size(), type, mode, out);
+    return out;
+}
+
+std::vector<uint8_t> cabacEncodeSymbols(const std::vector<uint8_t>& symbols,
+                                        BinarizationType type, CabacContextMode mode)
+{
+    std::vector<uint8_t> out;
+    encodeSymbols(symbols.data(), symbols.size(), type, mode, out);
+    return out;
+}
+
+void cabacEncodeSymbols(const int* symbols, size_t n, BinarizationType type,
+                        CabacContextMode mode, std::vector<uint8_t>& out)
+{
+    encodeSymbols(symbols, n, type, mode, out);
+}
+
+void cabacEncodeSymbols(const uint8_t* symbols, size_t n, BinarizationType type,
+                        CabacContextMode mode, std::vector<uint8_t>& out)
+{
+    encodeSymbols(symbols, n, type, mode, out);
+}
+
+void cabacEncodeSymbols(const int* symbols, size_t n, int binarizationId,
+                        CabacContextMode mode, std::vector<uint8_t>& out)
+{
+    encodeSymbols(symbols, n, binarizationId, mode, out);
+}
+
+void cabacEncodeSymbols(const uint8_t* symbols, size_t n, int binarizationId,
+                        CabacContextMode mode, std::vector<uint8_t>& out)
+{
+    encodeSymbols(symbols, n, binarizationId, mode, out);
+}
+
+std::vector<int> cabacDecodeSymbols(const std::vector<uint8_t>& stream) {
+    std::vector<int> out(cabacDecodedSize(stream.data(), stream.size()));
+    cabacDecodeSymbols(stream.data(), stream.size(), out.data(), out.size());
+    return out;
+}
+
+size_t cabacDecodedSize(const uint8_t* stream, size_t size) {
+    return readSymbolHeader(stream, size).n;
+}
+
+size_t cabacDecodeSymbols(const uint8_t* stream, size_t size,
+                          int* out, size_t capacity)
+{
+    return decodeSymbols(stream, size, out, capacity);
+}
+
+size_t cabacDecodeSymbols(const uint8_t* stream, size_t size,
+                          uint8_t* out, size_t capacity)
+{
+    return decodeSymbols(stream, size, out, capacity);
+}
+
+std::vector<uint8_t> cabacEncodeRun(const int* symbols, size_t n,
+                                    BinarizationType type, CabacContextMode mode)
+{
+    return encodeRun(symbols, n, type, mode);
+}
+
+std::vector<uint8_t> cabacEncodeRun(const uint8_t* symbols, size_t n,
+                                    BinarizationType type, CabacContextMode mode)
+{
+    return encodeRun(symbols, n, type, mode);
+}
+
+void cabacDecodeRun(const uint8_t* data, size_t size, BinarizationType type,
+                    CabacContextMode mode, int* out, size_t n)
+{
+    decodeRun(data, size, type, mode, out, n);
+}
+
+void cabacDecodeRun(const uint8_t* data, size_t size, BinarizationType type,
+                    CabacContextMode mode, uint8_t* out, size_t n)
+{
+    decodeRun(data, size, type, mode, out, n);
+}
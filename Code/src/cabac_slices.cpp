@@ -0,0 +1,154 @@
+#include "cabac_slices.hpp"
+#include "byte_io.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    struct SliceHeader {
+        uint32_t N = 0;
+        BinarizationType type = BinarizationType::Good;
+        CabacContextMode mode = CabacContextMode::BinIndex;
+        uint32_t sliceSize = 0;
+        std::vector<uint64_t> ends; // one per slice
+        size_t payloadStart = 0;
+
+        size_t slices() const { return ends.size(); }
+        size_t rawSize(size_t i) const {
+            return std::min<size_t>(sliceSize, N - i * size_t(sliceSize));
+        }
+    };
+
+    SliceHeader readHeader(const uint8_t* stream, size_t size) {
+        SliceHeader h;
+        size_t offset = 0;
+        h.N = readU32LE(stream, size, offset);
+        if (size < offset + 2) {
+            throw std::runtime_error("cabacDecodeSlices: stream too short");
+        }
+        const uint8_t type = stream[offset++];
+        const uint8_t mode = stream[offset++];
+        if (type > static_cast<uint8_t>(BinarizationType::Bad) ||
+            mode > static_cast<uint8_t>(CabacContextMode::BinIndexPrevSymbol)) {
+            throw std::runtime_error("cabacDecodeSlices: bad coding parameters");
+        }
+        h.type = static_cast<BinarizationType>(type);
+        h.mode = static_cast<CabacContextMode>(mode);
+        h.sliceSize = readU32LE(stream, size, offset);
+        const uint32_t nSlices = readU32LE(stream, size, offset);
+        if (h.sliceSize == 0 ||
+            nSlices != (uint64_t(h.N) + h.sliceSize - 1) / h.sliceSize) {
+            throw std::runtime_error("cabacDecodeSlices: inconsistent slice count");
+        }
+
+        h.ends.resize(nSlices);
+        uint64_t prev = 0;
+        for (auto& e : h.ends) {
+            e = readU64LE(stream, size, offset);
+            if (e < prev) {
+                throw std::runtime_error("cabacDecodeSlices: bad substream offsets");
+            }
+            prev = e;
+        }
+        h.payloadStart = offset;
+        if (prev > size - offset) {
+            throw std::runtime_error("cabacDecodeSlices: truncated payload");
+        }
+        if (!cabacBinCountFits(h.N, static_cast<size_t>(prev) + nSlices)) {
+            throw std::runtime_error("cabacDecodeSlices: symbol count exceeds the payload");
+        }
+        return h;
+    }
+
+    template <class Sym>
+    std::vector<uint8_t> encodeImpl(const std::vector<Sym>& symbols,
+                                    const CabacSliceOptions& opt)
+    {
+        if (opt.sliceSize == 0 || opt.sliceSize > UINT32_MAX) {
+            throw std::runtime_error("cabacEncodeSlices: bad slice size");
+        }
+        if (symbols.size() > UINT32_MAX) {
+            throw std::runtime_error("cabacEncodeSlices: too many symbols");
+        }
+
+        const size_t N = symbols.size();
+        const size_t nSlices = (N + opt.sliceSize - 1) / opt.sliceSize;
+        std::vector<std::vector<uint8_t>> sub(nSlices);
+
+        parallelForThreads(nSlices, opt.threads, [&](size_t i) {
+            const size_t lo = i * opt.sliceSize;
+            const size_t n = std::min(N, lo + opt.sliceSize) - lo;
+            sub[i] = cabacEncodeRun(symbols.data() + lo, n, opt.type, opt.mode);
+        });
+
+        std::vector<uint8_t> out;
+        writeU32LE(out, static_cast<uint32_t>(N));
+        out.push_back(static_cast<uint8_t>(opt.type));
+        out.push_back(static_cast<uint8_t>(opt.mode));
+        writeU32LE(out, static_cast<uint32_t>(opt.sliceSize));
+        writeU32LE(out, static_cast<uint32_t>(nSlices));
+
+        uint64_t end = 0;
+        for (const auto& s : sub) {
+            end += s.size();
+            writeU64LE(out, end);
+        }
+        out.reserve(out.size() + static_cast<size_t>(end));
+        for (const auto& s : sub) out.insert(out.end(), s.begin(), s.end());
+        return out;
+    }
+
+    template <class Out>
+    size_t decodeImpl(const uint8_t* stream, size_t size, Out* out,
+                      size_t capacity, unsigned threads)
+    {
+        const SliceHeader h = readHeader(stream, size);
+        if (h.N > capacity) {
+            throw std::runtime_error("cabacDecodeSlices: output buffer too small");
+        }
+        parallelForThreads(h.slices(), threads, [&](size_t i) {
+            const uint64_t lo = (i == 0) ? 0 : h.ends[i - 1];
+            cabacDecodeRun(stream + h.payloadStart + lo,
+                           static_cast<size_t>(h.ends[i] - lo), h.type, h.mode,
+                           out + i * size_t(h.sliceSize), h.rawSize(i));
+        });
+        return h.N;
+    }
+} // namespace
+
+std::vector<uint8_t> cabacEncodeSlices(const std::vector<int>& symbols,
+                                       const CabacSliceOptions& opt)
+{
+    return encodeImpl(symbols, opt);
+}
+
+std::vector<uint8_t> cabacEncodeSlices(const std::vector<uint8_t>& symbols,
+                                       const CabacSliceOptions& opt)
+{
+    return encodeImpl(symbols, opt);
+}
+
+std::vector<int> cabacDecodeSlices(const std::vector<uint8_t>& stream,
+                                   unsigned threads)
+{
+    std::vector<int> out(cabacSlicedSize(stream.data(), stream.size()));
+    cabacDecodeSlices(stream.data(), stream.size(), out.data(), out.size(), threads);
+    return out;
+}
+
+size_t cabacSlicedSize(const uint8_t* stream, size_t size) {
+    return readHeader(stream, size).N;
+}
+
+size_t cabacDecodeSlices(const uint8_t* stream, size_t size, int* out,
+                         size_t capacity, unsigned threads)
+{
+    return decodeImpl(stream, size, out, capacity, threads);
+}
+
+size_t cabacDecodeSlices(const uint8_t* stream, size_t size, uint8_t* out,
+                         size_t capacity, unsigned threads)
+{
+    return decodeImpl(stream, size, out, capacity, threads);
+}
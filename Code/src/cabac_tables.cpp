@@ -1,9 +1,11 @@
 #include "cabac_tables.hpp"
 
+#include <array>
+
 // Full CABAC LPS range table (64 states × 4 qIdx).
 // These are taken from the original JM reference software.
 
-const uint8_t cabacRangeTabLPS[64][4] =
+constexpr uint8_t cabacRangeTabLPS[64][4] =
 {
     {128,176,208,240},{128,167,197,227},{128,158,187,216},{123,150,178,205},
     {116,142,169,195},{111,135,160,185},{105,128,152,175},{100,122,144,166},
@@ -19,22 +21,83 @@ const uint8_t cabacRangeTabLPS[64][4] =
     { 14, 18, 21, 24},{ 14, 17, 20, 23},{ 13, 16, 19, 22},{ 12, 15, 18, 21},
     { 12, 14, 17, 20},{ 11, 14, 16, 19},{ 11, 13, 15, 18},{ 10, 12, 15, 17},
     { 10, 12, 14, 16},{  9, 11, 13, 15},{  9, 11, 12, 14},{  8, 10, 12, 14},
-    {  8,  9, 11, 13},{  7,  9, 11, 12},{  7,  9, 10, 12},{  7,  8, 10, 11}
+    {  8,  9, 11, 13},{  7,  9, 11, 12},{  7,  9, 10, 12},{  7,  8, 10, 11},
+    {  6,  8,  9, 11},{  6,  7,  9, 10},{  6,  7,  8,  9},{  2,  2,  2,  2}
 };
 
-// Transition tables (LPS & MPS)
-const uint8_t cabacTransIdxLPS[64] =
-{
-    0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,
-    16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,
-    32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,
-    48,49,50,51,52,53,54,55,56,57,58,59,60,61,62,63
-};
+namespace {
+    // An MPS moves one state toward p = 0.01875.
+    constexpr std::array<uint8_t, 64> makeTransIdxMPS() {
+        std::array<uint8_t, 64> t{};
+        for (int s = 0; s < 63; ++s) t[s] = static_cast<uint8_t>(s < 62 ? s + 1 : 62);
+        t[63] = 63;
+        return t;
+    }
+
+    constexpr std::array<uint8_t, 64> TRANS_MPS = makeTransIdxMPS();
+
+    // transIdxLPS, H.264 Table 9-45. Rounding the recursion
+    // p' = alpha * p + (1 - alpha) to the nearest state does not give
+    // this table (it differs in ten entries), so it is spelled out.
+    constexpr std::array<uint8_t, 64> TRANS_LPS = {
+         0,  0,  1,  2,  2,  4,  4,  5,  6,  7,  8,  9,  9, 11, 11, 12,
+        13, 13, 15, 15, 16, 16, 18, 18, 19, 19, 21, 21, 22, 22, 23, 24,
+        24, 25, 26, 26, 27, 27, 28, 29, 29, 30, 30, 30, 31, 32, 32, 33,
+        33, 33, 34, 34, 35, 35, 35, 36, 36, 36, 37, 37, 37, 38, 38, 63
+    };
+
+    constexpr std::array<CabacTransition, 128> makeTransTab() {
+        std::array<CabacTransition, 128> tab{};
+        for (int s = 0; s < 64; ++s) {
+            for (int mps = 0; mps < 2; ++mps) {
+                CabacTransition& e = tab[2 * s + mps];
+                for (int q = 0; q < 4; ++q) e.rangeLPS[q] = cabacRangeTabLPS[s][q];
+                const int lpsMps = (s == 0) ? mps ^ 1 : mps;
+                e.next[mps]     = static_cast<uint8_t>(TRANS_MPS[s] << 1 | mps);
+                e.next[mps ^ 1] = static_cast<uint8_t>(TRANS_LPS[s] << 1 | lpsMps);
+            }
+        }
+        return tab;
+    }
+
+    constexpr std::array<CabacTransition, 128> TRANS_TAB = makeTransTab();
+
+    // An LPS never moves away from p = 0.5 and its target does not
+    // decrease with s; the fused table holds exactly these successors
+    // and the range table rows, for all 128 contexts.
+    constexpr bool checkTables() {
+        for (int s = 0; s < 63; ++s) {
+            if (TRANS_LPS[s] > s || (s > 0 && TRANS_LPS[s] < TRANS_LPS[s - 1])) return false;
+        }
+        if (TRANS_LPS[63] != 63 || TRANS_MPS[62] != 62 || TRANS_MPS[63] != 63) return false;
+        for (int s = 0; s < 64; ++s) {
+            for (int mps = 0; mps < 2; ++mps) {
+                const CabacTransition& e = TRANS_TAB[2 * s + mps];
+                const int lpsMps = (s == 0) ? mps ^ 1 : mps;
+                if (e.next[mps] != (TRANS_MPS[s] << 1 | mps)) return false;
+                if (e.next[mps ^ 1] != (TRANS_LPS[s] << 1 | lpsMps)) return false;
+                for (int q = 0; q < 4; ++q) {
+                    if (e.rangeLPS[q] != cabacRangeTabLPS[s][q]) return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static_assert(checkTables(), "CABAC transition tables differ from H.264");
+} // namespace
+
+// State transitions on an MPS and on an LPS.
+const std::array<uint8_t, 64> cabacTransIdxMPS = TRANS_MPS;
+const std::array<uint8_t, 64> cabacTransIdxLPS = TRANS_LPS;
+
+const std::array<CabacTransition, 128> cabacTransTab = TRANS_TAB;
 
-const uint8_t cabacTransIdxMPS[64] =
+// Renormalization shift indexed by (range >> 3), for range in [6, 510].
+const uint8_t cabacRenormShift[64] =
 {
-    1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,
-    17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,
-    33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,48,
-    49,50,51,52,53,54,55,56,57,58,59,60,61,62,63,63
+    6,5,4,4,3,3,3,3,2,2,2,2,2,2,2,2,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "checksum.hpp"
+
+namespace {
+    constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+    constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+    constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+    inline uint64_t rotl(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t load64(const uint8_t* p) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+        return v;
+    }
+
+    inline uint32_t load32(const uint8_t* p) {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+        return v;
+    }
+
+    inline uint64_t round(uint64_t acc, uint64_t lane) {
+        acc += lane * P2;
+        acc = rotl(acc, 31);
+        return acc * P1;
+    }
+
+    inline uint64_t mergeRound(uint64_t h, uint64_t acc) {
+        h ^= round(0, acc);
+        return h * P1 + P4;
+    }
+} // namespace
+
+uint64_t xxhash64(const uint8_t* data, size_t size, uint64_t seed) {
+    const uint8_t* p = data;
+    const uint8_t* const end = data + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        // Four independent accumulators over 32-byte stripes.
+        uint64_t v1 = seed + P1 + P2;
+        uint64_t v2 = seed + P2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - P1;
+        const uint8_t* const limit = end - 32;
+        do {
+            v1 = round(v1, load64(p));
+            v2 = round(v2, load64(p + 8));
+            v3 = round(v3, load64(p + 16));
+            v4 = round(v4, load64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    } else {
+        h = seed + P5;
+    }
+
+    h += static_cast<uint64_t>(size);
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= round(0, load64(p));
+        h = rotl(h, 27) * P1 + P4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(load32(p)) * P1;
+        h = rotl(h, 23) * P2 + P3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= static_cast<uint64_t>(*p) * P5;
+        h = rotl(h, 11) * P1;
+    }
+
+    // Avalanche
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
@@ -0,0 +1,104 @@
+#include "codec_context.hpp"
+#include "cabac.hpp"
+#include "rans.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+// ============================
+// EncoderContext
+// ============================
+
+const std::vector<uint8_t>& EncoderContext::ransEncode(const uint8_t* symbols, size_t n) {
+    ::ransEncode(symbols, n, stream_);
+    return stream_;
+}
+
+const std::vector<uint8_t>& EncoderContext::ransEncode(const int* symbols, size_t n) {
+    ::ransEncode(symbols, n, stream_);
+    return stream_;
+}
+
+const std::vector<uint8_t>& EncoderContext::ransEncodeInterleaved(const uint8_t* symbols,
+                                                                  size_t n, int lanes)
+{
+    ::ransEncodeInterleaved(symbols, n, lanes, stream_);
+    return stream_;
+}
+
+const std::vector<uint8_t>& EncoderContext::ransEncodeInterleaved(const int* symbols,
+                                                                  size_t n, int lanes)
+{
+    ::ransEncodeInterleaved(symbols, n, lanes, stream_);
+    return stream_;
+}
+
+const std::vector<uint8_t>& EncoderContext::ransEncodeSmall(const uint8_t* symbols, size_t n,
+                                                            int table)
+{
+    ::ransEncodeSmall(symbols, n, table, stream_);
+    return stream_;
+}
+
+const std::vector<uint8_t>& EncoderContext::cabacEncodeSymbols(const uint8_t* symbols, size_t n,
+                                                               BinarizationType type,
+                                                               CabacContextMode mode)
+{
+    ::cabacEncodeSymbols(symbols, n, type, mode, stream_);
+    return stream_;
+}
+
+const BinString& EncoderContext::binarize(const uint8_t* symbols, size_t n,
+                                          BinarizationType type)
+{
+    binarizeSequencePacked(symbols, n, type, bins_);
+    return bins_;
+}
+
+void EncoderContext::release() {
+    std::vector<uint8_t>().swap(stream_);
+    bins_ = BinString();
+}
+
+// ============================
+// DecoderContext
+// ============================
+
+const std::vector<uint8_t>& DecoderContext::ransDecode(const uint8_t* stream, size_t size) {
+    // resize() within the current capacity does not reallocate.
+    symbols_.resize(ransDecodedSize(stream, size));
+    ::ransDecode(stream, size, symbols_.data(), symbols_.size());
+    return symbols_;
+}
+
+const std::vector<uint8_t>& DecoderContext::ransDecodeInterleaved(const uint8_t* stream,
+                                                                  size_t size)
+{
+    symbols_.resize(ransDecodedSize(stream, size));
+    ::ransDecodeInterleaved(stream, size, symbols_.data(), symbols_.size());
+    return symbols_;
+}
+
+const std::vector<uint8_t>& DecoderContext::ransDecodeSmall(const uint8_t* stream, size_t size) {
+    symbols_.resize(ransSmallDecodedSize(stream, size));
+    ::ransDecodeSmall(stream, size, symbols_.data(), symbols_.size());
+    return symbols_;
+}
+
+const std::vector<uint8_t>& DecoderContext::cabacDecodeSymbols(const uint8_t* stream,
+                                                               size_t size)
+{
+    symbols_.resize(cabacDecodedSize(stream, size));
+    ::cabacDecodeSymbols(stream, size, symbols_.data(), symbols_.size());
+    return symbols_;
+}
+
+const BinString& DecoderContext::arithDecodeBins(const uint8_t* stream, size_t size) {
+    ::arithDecodeBins(stream, size, bins_);
+    return bins_;
+}
+
+void DecoderContext::release() {
+    std::vector<uint8_t>().swap(symbols_);
+    bins_ = BinString();
+}
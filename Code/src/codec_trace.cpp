@@ -0,0 +1,169 @@
+#include "codec_trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+    // Live blocks, plus what exited threads left behind.
+    struct TraceRegistry {
+        std::mutex mutex;
+        std::vector<CodecTraceBlock*> live;
+        CodecTrace retired;
+    };
+
+    TraceRegistry& traceRegistry() {
+        static TraceRegistry r;
+        return r;
+    }
+
+    thread_local CodecTraceHook traceHook = nullptr;
+    thread_local void* traceHookUser = nullptr;
+
+    void addBlock(CodecTrace& t, const CodecTraceBlock& b) {
+        for (size_t i = 0; i < CODEC_COUNTER_COUNT; ++i) {
+            t.counters[i] += b.counters[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < CODEC_TRACE_CONTEXTS; ++i) {
+            t.contextBins[i] += b.contextBins[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < CODEC_STAGE_COUNT; ++i) {
+            t.stages[i].calls       += b.stageCalls[i].load(std::memory_order_relaxed);
+            t.stages[i].nanoseconds += b.stageNs[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    // Resetting another thread's counters races with its next store; the
+    // snapshot is exact when the codecs are idle.
+    template <size_t N>
+    void clear(std::array<std::atomic<uint64_t>, N>& a) {
+        for (auto& v : a) v.store(0, std::memory_order_relaxed);
+    }
+} // namespace
+
+thread_local CodecTraceBlock codecTraceTls;
+
+CodecTraceBlock::CodecTraceBlock() {
+    TraceRegistry& r = traceRegistry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.live.push_back(this);
+}
+
+CodecTraceBlock::~CodecTraceBlock() {
+    TraceRegistry& r = traceRegistry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    addBlock(r.retired, *this);
+    r.live.erase(std::remove(r.live.begin(), r.live.end(), this), r.live.end());
+}
+
+CodecTally::~CodecTally() {
+    CodecTraceBlock& b = codecTraceTls;
+    codecTraceAdd(b.counters[static_cast<size_t>(CodecCounter::CabacContextBins)], contextBins);
+    codecTraceAdd(b.counters[static_cast<size_t>(CodecCounter::CabacBypassBins)], bypassBins);
+    codecTraceAdd(b.counters[static_cast<size_t>(CodecCounter::CabacLps)], lps);
+    codecTraceAdd(b.counters[static_cast<size_t>(CodecCounter::CabacMps)], contextBins - lps);
+    for (size_t i = 0; i < CODEC_TRACE_CONTEXTS; ++i) codecTraceAdd(b.contextBins[i], byContext[i]);
+}
+
+CodecStageTimer::CodecStageTimer(CodecStage s)
+    : stage_(s)
+{
+    if (traceHook) traceHook(stage_, true, traceHookUser);
+    start_ = std::chrono::steady_clock::now();
+}
+
+CodecStageTimer::~CodecStageTimer() {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_).count();
+    const size_t i = static_cast<size_t>(stage_);
+    codecTraceAdd(codecTraceTls.stageCalls[i], 1);
+    codecTraceAdd(codecTraceTls.stageNs[i], static_cast<uint64_t>(ns));
+    if (traceHook) traceHook(stage_, false, traceHookUser);
+}
+
+const char* codecCounterName(CodecCounter c) {
+    switch (c) {
+        case CodecCounter::RansEncodeSymbols: return "rans_encode_symbols";
+        case CodecCounter::RansDecodeSymbols: return "rans_decode_symbols";
+        case CodecCounter::RansWordsOut:      return "rans_words_out";
+        case CodecCounter::RansWordsIn:       return "rans_words_in";
+        case CodecCounter::RansBytesOut:      return "rans_bytes_out";
+        case CodecCounter::CabacContextBins:  return "cabac_context_bins";
+        case CodecCounter::CabacBypassBins:   return "cabac_bypass_bins";
+        case CodecCounter::CabacMps:          return "cabac_mps";
+        case CodecCounter::CabacLps:          return "cabac_lps";
+        case CodecCounter::CabacBytesOut:     return "cabac_bytes_out";
+        case CodecCounter::Count:             break;
+    }
+    return "?";
+}
+
+const char* codecStageName(CodecStage s) {
+    switch (s) {
+        case CodecStage::Histogram: return "histogram";
+        case CodecStage::Normalize: return "normalize";
+        case CodecStage::Encode:    return "encode";
+        case CodecStage::Decode:    return "decode";
+        case CodecStage::Binarize:  return "binarize";
+        case CodecStage::Pack:      return "pack";
+        case CodecStage::Count:     break;
+    }
+    return "?";
+}
+
+CodecTrace codecTraceSnapshot() {
+    TraceRegistry& r = traceRegistry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    CodecTrace t = r.retired;
+    for (const CodecTraceBlock* b : r.live) addBlock(t, *b);
+    return t;
+}
+
+void codecTraceReset() {
+    TraceRegistry& r = traceRegistry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.retired = CodecTrace();
+    for (CodecTraceBlock* b : r.live) {
+        clear(b->counters);
+        clear(b->contextBins);
+        clear(b->stageCalls);
+        clear(b->stageNs);
+    }
+}
+
+std::string codecTraceJson(const CodecTrace& t) {
+    std::string s = "{\"enabled\":";
+    s += codecInstrumentationEnabled() ? "true" : "false";
+    char buf[96];
+
+    s += ",\"counters\":{";
+    for (size_t i = 0; i < CODEC_COUNTER_COUNT; ++i) {
+        std::snprintf(buf, sizeof(buf), "%s\"%s\":%llu", i ? "," : "",
+                      codecCounterName(static_cast<CodecCounter>(i)),
+                      static_cast<unsigned long long>(t.counters[i]));
+        s += buf;
+    }
+    s += "},\"context_bins\":[";
+    for (size_t i = 0; i < CODEC_TRACE_CONTEXTS; ++i) {
+        std::snprintf(buf, sizeof(buf), "%s%llu", i ? "," : "",
+                      static_cast<unsigned long long>(t.contextBins[i]));
+        s += buf;
+    }
+    s += "],\"stages\":{";
+    for (size_t i = 0; i < CODEC_STAGE_COUNT; ++i) {
+        std::snprintf(buf, sizeof(buf), "%s\"%s\":{\"calls\":%llu,\"ns\":%llu}", i ? "," : "",
+                      codecStageName(static_cast<CodecStage>(i)),
+                      static_cast<unsigned long long>(t.stages[i].calls),
+                      static_cast<unsigned long long>(t.stages[i].nanoseconds));
+        s += buf;
+    }
+    s += "}}";
+    return s;
+}
+
+void codecSetTraceHook(CodecTraceHook hook, void* user) {
+    traceHook = hook;
+    traceHookUser = user;
+}
@@ -0,0 +1,371 @@
+#include "corpus.hpp"
+#include "mapped_file.hpp"
+#include "symbol_pack.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    // Drift re-blends its weights every DRIFT_STEP symbols; chunks start
+    // on a step boundary.
+    constexpr size_t DRIFT_STEP = 1024;
+    static_assert(CORPUS_CHUNK % DRIFT_STEP == 0, "chunks must hold whole drift steps");
+
+    using Weights = std::array<double, 4>;
+
+    // Cumulative cuts on a 32-bit uniform: the symbol is the number of
+    // cuts at or below it. A symbol with zero weight has an empty range.
+    struct Sampler {
+        std::array<uint64_t, 3> cut{};
+
+        uint8_t draw(uint32_t u) const {
+            return static_cast<uint8_t>((u >= cut[0]) + (u >= cut[1]) + (u >= cut[2]));
+        }
+    };
+
+    double checkedTotal(const Weights& w) {
+        double total = 0.0;
+        for (double v : w) {
+            if (!(v >= 0.0) || !std::isfinite(v)) {
+                throw std::runtime_error("generateCorpus: weights must be finite and >= 0");
+            }
+            total += v;
+        }
+        if (total <= 0.0) throw std::runtime_error("generateCorpus: weights sum to zero");
+        return total;
+    }
+
+    Sampler makeSampler(const Weights& w) {
+        const double total = checkedTotal(w);
+        Sampler s;
+        double c = 0.0;
+        for (size_t k = 0; k < 3; ++k) {
+            c += w[k];
+            // c == total exactly once the remaining weights are zero.
+            s.cut[k] = static_cast<uint64_t>(std::ldexp(c / total, 32));
+        }
+        return s;
+    }
+
+    Weights normalized(const Weights& w) {
+        const double total = checkedTotal(w);
+        Weights n;
+        for (size_t k = 0; k < 4; ++k) n[k] = w[k] / total;
+        return n;
+    }
+
+    // Stationary distribution of the chain, by iterating the lazy chain
+    // (P + I) / 2, which has the same fixed point and cannot oscillate.
+    Weights stationary(const std::array<Weights, 4>& rows) {
+        Weights pi{0.25, 0.25, 0.25, 0.25};
+        for (int it = 0; it < 1000; ++it) {
+            Weights next{};
+            for (size_t a = 0; a < 4; ++a) {
+                for (size_t b = 0; b < 4; ++b) next[b] += pi[a] * rows[a][b];
+            }
+            for (size_t b = 0; b < 4; ++b) pi[b] = 0.5 * (pi[b] + next[b]);
+        }
+        return pi;
+    }
+
+    // Everything the chunk fillers need, validated once.
+    struct Source {
+        CorpusKind kind;
+        uint64_t seed;
+        double period;
+        Sampler first, second;        // weights, alt
+        std::array<Sampler, 4> rows;  // Markov
+        Sampler start;                // Markov stationary
+        Weights from, to;             // Drift, normalized
+    };
+
+    Source prepare(const CorpusSpec& spec) {
+        Source s;
+        s.kind   = spec.kind;
+        s.seed   = spec.seed;
+        s.period = spec.period;
+        switch (spec.kind) {
+            case CorpusKind::Iid:
+                s.first = makeSampler(spec.weights);
+                break;
+            case CorpusKind::Markov: {
+                std::array<Weights, 4> p;
+                for (size_t k = 0; k < 4; ++k) {
+                    s.rows[k] = makeSampler(spec.transition[k]);
+                    p[k] = normalized(spec.transition[k]);
+                }
+                s.start = makeSampler(stationary(p));
+                break;
+            }
+            case CorpusKind::Bursty:
+            case CorpusKind::Drift:
+                if (!(spec.period >= 1.0)) {
+                    throw std::runtime_error("generateCorpus: period must be >= 1");
+                }
+                s.first  = makeSampler(spec.weights);
+                s.second = makeSampler(spec.alt);
+                s.from   = normalized(spec.weights);
+                s.to     = normalized(spec.alt);
+                break;
+            default:
+                throw std::runtime_error("generateCorpus: unknown corpus kind");
+        }
+        return s;
+    }
+
+    // Two symbols per 64-bit draw.
+    void fillIid(const Sampler& d, CorpusRng& rng, uint8_t* out, size_t n) {
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            const uint64_t r = rng.next();
+            out[i]     = d.draw(static_cast<uint32_t>(r));
+            out[i + 1] = d.draw(static_cast<uint32_t>(r >> 32));
+        }
+        if (i < n) out[i] = d.draw(static_cast<uint32_t>(rng.next()));
+    }
+
+    // Each uniform is drawn through all four rows off the critical path,
+    // leaving a 2-bit select by the previous symbol as the only serial
+    // step: a row lookup per symbol would chain a load into every draw.
+    unsigned drawRows(const Source& s, uint32_t u) {
+        return s.rows[0].draw(u) | s.rows[1].draw(u) << 2 |
+               s.rows[2].draw(u) << 4 | s.rows[3].draw(u) << 6;
+    }
+
+    void fillMarkov(const Source& s, CorpusRng& rng, uint8_t* out, size_t n) {
+        unsigned prev = s.start.draw(static_cast<uint32_t>(rng.next()));
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            const uint64_t r = rng.next();
+            const unsigned lo = drawRows(s, static_cast<uint32_t>(r));
+            const unsigned hi = drawRows(s, static_cast<uint32_t>(r >> 32));
+            prev = (lo >> (2 * prev)) & 3u;
+            out[i] = static_cast<uint8_t>(prev);
+            prev = (hi >> (2 * prev)) & 3u;
+            out[i + 1] = static_cast<uint8_t>(prev);
+        }
+        if (i < n) out[i] = s.rows[prev].draw(static_cast<uint32_t>(rng.next()));
+    }
+
+    // Run lengths are geometric, hence memoryless, so a chunk can start
+    // a fresh run in a regime picked uniformly (both are equally likely).
+    void fillBursty(const Source& s, CorpusRng& rng, uint8_t* out, size_t n) {
+        const double lnStay = std::log1p(-1.0 / s.period); // -inf at period 1
+        bool burst = rng.next() & 1u;
+        for (size_t i = 0; i < n; ) {
+            const double run = 1.0 + std::floor(std::log(rng.unit()) / lnStay);
+            const size_t len = static_cast<size_t>(std::min(run, double(n - i)));
+            fillIid(burst ? s.second : s.first, rng, out + i, len);
+            i += len;
+            burst = !burst;
+        }
+    }
+
+    // Triangle wave over period symbols, sampled at the middle of each
+    // step of the global position.
+    void fillDrift(const Source& s, CorpusRng& rng, uint8_t* out, size_t n, size_t pos) {
+        for (size_t i = 0; i < n; i += DRIFT_STEP) {
+            const double mid = double(pos + i) + 0.5 * DRIFT_STEP;
+            const double phase = std::fmod(mid, s.period) / s.period;
+            const double t = phase < 0.5 ? 2.0 * phase : 2.0 - 2.0 * phase;
+            Weights w;
+            for (size_t k = 0; k < 4; ++k) w[k] = (1.0 - t) * s.from[k] + t * s.to[k];
+            fillIid(makeSampler(w), rng, out + i, std::min(DRIFT_STEP, n - i));
+        }
+    }
+
+    void fillChunk(const Source& s, size_t chunk, uint8_t* out, size_t n) {
+        CorpusRng rng(s.seed ^ (uint64_t(chunk) * 0xD6E8FEB86659FD93ull));
+        switch (s.kind) {
+            case CorpusKind::Iid:    fillIid(s.first, rng, out, n); break;
+            case CorpusKind::Markov: fillMarkov(s, rng, out, n); break;
+            case CorpusKind::Bursty: fillBursty(s, rng, out, n); break;
+            case CorpusKind::Drift:  fillDrift(s, rng, out, n, chunk * CORPUS_CHUNK); break;
+        }
+    }
+
+    CorpusSpec iid(const Weights& w) {
+        CorpusSpec s;
+        s.weights = w;
+        return s;
+    }
+
+    struct Preset {
+        const char* name;
+        CorpusSpec spec;
+    };
+
+    const std::vector<Preset>& presets() {
+        static const std::vector<Preset> p = [] {
+            CorpusSpec markov;
+            markov.kind = CorpusKind::Markov;
+            markov.transition = {{
+                {90,  6,  3,  1},
+                {30, 50, 15,  5},
+                {15, 25, 50, 10},
+                {10, 15, 25, 50},
+            }};
+
+            CorpusSpec bursty;
+            bursty.kind    = CorpusKind::Bursty;
+            bursty.weights = {97, 1, 1, 1};
+            bursty.alt     = {25, 25, 25, 25};
+            bursty.period  = 2048;
+
+            CorpusSpec drift = bursty;
+            drift.kind   = CorpusKind::Drift;
+            drift.period = double(size_t(1) << 20);
+
+            return std::vector<Preset>{
+                {"p70",          iid({70, 10, 10, 10})},
+                {"uniform",      iid({25, 25, 25, 25})},
+                {"near_uniform", iid({26, 25, 25, 24})},
+                {"linear",       iid({40, 30, 20, 10})},
+                {"p97",          iid({97, 1, 1, 1})},
+                {"p999",         iid({999, 0.4, 0.4, 0.2})},
+                {"p9999",        iid({9999, 0.4, 0.4, 0.2})},
+                {"markov",       markov},
+                {"bursty",       bursty},
+                {"drift",        drift},
+            };
+        }();
+        return p;
+    }
+
+    bool allBelow4(const uint8_t* p, size_t n) {
+        uint64_t bad = 0;
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            uint64_t w;
+            std::memcpy(&w, p + i, 8);
+            bad |= w;
+        }
+        for (; i < n; ++i) bad |= p[i];
+        return (bad & 0xFCFCFCFCFCFCFCFCull) == 0;
+    }
+} // namespace
+
+CorpusSpec corpusPreset(const std::string& name) {
+    for (const Preset& p : presets()) {
+        if (name == p.name) return p.spec;
+    }
+    throw std::runtime_error("corpusPreset: unknown corpus '" + name + "'");
+}
+
+const std::vector<const char*>& corpusPresetNames() {
+    static const std::vector<const char*> names = [] {
+        std::vector<const char*> v;
+        for (const Preset& p : presets()) v.push_back(p.name);
+        return v;
+    }();
+    return names;
+}
+
+void generateCorpus(const CorpusSpec& spec, uint8_t* out, size_t n) {
+    const Source s = prepare(spec);
+    for (size_t c = 0; c * CORPUS_CHUNK < n; ++c) {
+        const size_t begin = c * CORPUS_CHUNK;
+        fillChunk(s, c, out + begin, std::min(CORPUS_CHUNK, n - begin));
+    }
+}
+
+void generateCorpus(const CorpusSpec& spec, uint8_t* out, size_t n, ThreadPool& pool) {
+    const Source s = prepare(spec);
+    const size_t chunks = (n + CORPUS_CHUNK - 1) / CORPUS_CHUNK;
+    pool.parallelFor(chunks, [&](size_t c) {
+        const size_t begin = c * CORPUS_CHUNK;
+        fillChunk(s, c, out + begin, std::min(CORPUS_CHUNK, n - begin));
+    });
+}
+
+std::vector<uint8_t> generateCorpus(const CorpusSpec& spec, size_t n) {
+    std::vector<uint8_t> out(n);
+    generateCorpus(spec, out.data(), n);
+    return out;
+}
+
+// ==============================
+// Captured dumps
+// ==============================
+
+std::vector<uint8_t> loadSymbolDump(const std::string& path, DumpFormat format) {
+    const MappedFile file(path);
+    const uint8_t* p = file.data();
+    const size_t size = file.size();
+
+    if (format == DumpFormat::Auto) {
+        format = allBelow4(p, size) ? DumpFormat::Bytes : DumpFormat::Text;
+    }
+
+    std::vector<uint8_t> out;
+    switch (format) {
+        case DumpFormat::Bytes:
+            if (!allBelow4(p, size)) {
+                throw std::runtime_error("loadSymbolDump: byte outside 0..3 in " + path);
+            }
+            out.assign(p, p + size);
+            break;
+        case DumpFormat::Text:
+            out.reserve(size);
+            for (size_t i = 0; i < size; ++i) {
+                const uint8_t c = p[i];
+                if (c >= '0' && c <= '3') {
+                    out.push_back(static_cast<uint8_t>(c - '0'));
+                } else if (c != ' ' && c != '\t' && c != '\n' && c != '\r' && c != ',') {
+                    throw std::runtime_error("loadSymbolDump: unexpected character in " + path);
+                }
+            }
+            break;
+        case DumpFormat::Packed2:
+            out.resize(4 * size);
+            unpackSymbols2(p, out.size(), out.data());
+            break;
+        default:
+            throw std::runtime_error("loadSymbolDump: unknown format");
+    }
+    return out;
+}
+
+void saveSymbolDump(const std::string& path, const uint8_t* symbols, size_t n,
+                    DumpFormat format)
+{
+    if (!allBelow4(symbols, n)) {
+        throw std::runtime_error("saveSymbolDump: symbol out of range (0..3)");
+    }
+    std::vector<uint8_t> encoded;
+    const uint8_t* data = symbols;
+    size_t size = n;
+    switch (format) {
+        case DumpFormat::Auto:
+        case DumpFormat::Bytes:
+            break;
+        case DumpFormat::Text:
+            // 64 digits per line.
+            encoded.reserve(n + n / 64 + 1);
+            for (size_t i = 0; i < n; ++i) {
+                encoded.push_back(static_cast<uint8_t>('0' + symbols[i]));
+                if (i % 64 == 63 || i + 1 == n) encoded.push_back('\n');
+            }
+            data = encoded.data();
+            size = encoded.size();
+            break;
+        case DumpFormat::Packed2:
+            encoded = packSymbols2(symbols, n);
+            data = encoded.data();
+            size = encoded.size();
+            break;
+        default:
+            throw std::runtime_error("saveSymbolDump: unknown format");
+    }
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) throw std::runtime_error("saveSymbolDump: cannot open " + path);
+    const size_t put = size ? std::fwrite(data, 1, size, f) : 0;
+    const bool failed = put != size || std::fclose(f) != 0;
+    if (failed) throw std::runtime_error("saveSymbolDump: cannot write " + path);
+}
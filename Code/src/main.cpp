@@ -2,43 +2,48 @@
 #include <vector>
 #include <array>
 #include <cmath>
-#include <random>
 #include <algorithm>
 #include <iomanip>
 
 #include "cabac.hpp"
 #include "cabac_tables.hpp"
+#include "corpus.hpp"
 #include "rans.hpp"
+#include "symbol_pack.hpp"
+#include "symbol_stats.hpp"
+#include "tans.hpp"
 
 // Generate N symbols in {0,1,2,3} with probabilities 0.7,0.1,0.1,0.1
-std::vector<int> generateSource(int N) {
-    std::mt19937 rng(12345);
-    std::discrete_distribution<int> dist({70, 10, 10, 10});
-    std::vector<int> symbols;
-    symbols.reserve(N);
-    for (int i = 0; i < N; ++i) symbols.push_back(dist(rng));
-    return symbols;
+std::vector<uint8_t> generateSource(int N) {
+    return generateCorpus(corpusPreset("p70"), static_cast<size_t>(N));
 }
 
-double computeSymbolEntropy(const std::array<int,4>& counts, int N) {
-    double H = 0.0;
-    for (int k = 0; k < 4; ++k) {
-        if (counts[k] == 0) continue;
-        double p = double(counts[k]) / N;
-        H += -p * std::log2(p);
-    }
-    return H;
+double computeBinEntropy(const BinString& bits) {
+    return binaryEntropy(bits.countOnes(), bits.size());
 }
 
-double computeBinEntropy(const std::vector<int>& bits) {
-    if (bits.empty()) return 0.0;
-    int c0 = 0, c1 = 0;
-    for (int b : bits) (b ? c1 : c0)++;
-    double N = c0 + c1;
-    double H = 0.0;
-    if (c0 > 0) H += -(c0/N) * std::log2(c0/N);
-    if (c1 > 0) H += -(c1/N) * std::log2(c1/N);
-    return H;
+// Ideal rate with one context per bin position: sum over positions of
+// the conditional bin entropy, per symbol.
+double computeBinIndexEntropy(const BinString& bits, int N) {
+    std::array<double, 4> ones{}, total{};
+    int pos = 0;
+    for (size_t i = 0; i < bits.size(); ++i) {
+        int b = bits[i];
+        total[pos] += 1;
+        ones[pos] += b;
+        pos = (b && pos < 3) ? pos + 1 : 0;
+    }
+    double bitsTotal = 0.0;
+    for (int k = 0; k < 4; ++k) {
+        if (total[k] == 0) continue;
+        double p1 = ones[k] / total[k];
+        double p0 = 1.0 - p1;
+        double H = 0.0;
+        if (p0 > 0) H += -p0 * std::log2(p0);
+        if (p1 > 0) H += -p1 * std::log2(p1);
+        bitsTotal += H * total[k];
+    }
+    return bitsTotal / N;
 }
 
 int cabacFindState(double pLPS) {
@@ -54,38 +59,56 @@ int cabacFindState(double pLPS) {
 
 int main() {
     const int N = 1000;
-    auto symbols = generateSource(N);
+    auto source = generateSource(N);
+    std::vector<int> symbols(source.begin(), source.end());
 
-    std::array<int,4> counts{0,0,0,0};
-    for (int s : symbols) counts[s]++;
+    const SymbolHistogram hist = symbolHistogram(source.data(), source.size());
+    const auto& counts = hist.counts;
 
     std::cout << "Number of source symbols: " << N << "\n";
     std::cout << "Frequencies:\n";
     for (int k = 0; k < 4; ++k)
         std::cout << "  symbol " << k << ": " << counts[k] << "\n";
 
-    double Hsym = computeSymbolEntropy(counts, N);
+    double Hsym = symbolEntropy(hist);
     std::cout << std::fixed << std::setprecision(6);
     std::cout << "Theoretical symbol entropy H_sym = "
               << Hsym << " bits/symbol\n\n";
 
     // CABAC good
-    auto bitsGood = binarizeSequence(symbols, BinarizationType::Good);
+    auto bitsGood = binarizeSequencePacked(symbols, BinarizationType::Good);
     auto bytesGood = packBitsToBytes(bitsGood);
     double binsPerGood = double(bitsGood.size()) / N;
     double HbinGood = computeBinEntropy(bitsGood);
     double idealCABACgood = HbinGood * binsPerGood;
 
-    double p1 = std::count(bitsGood.begin(), bitsGood.end(), 1)
-                / double(bitsGood.size());
+    double p1 = bitsGood.countOnes() / double(bitsGood.size());
     double p0 = 1.0 - p1;
     double pLPS = std::min(p0, p1);
 
     int cabacState = cabacFindState(pLPS);
     double cabacModelP = cabacRangeTabLPS[cabacState][0] / 256.0;
 
+    auto cabacStream  = arithEncodeBits(bitsGood);
+    auto cabacDecoded = arithDecodeBins(cabacStream);
+    bool okCabac      = (cabacDecoded == bitsGood);
+
+    int cabacBytes = int(cabacStream.size());
+    double cabacRate = 8.0 * cabacBytes / N;
+
+    // CABAC with per-bin-index contexts (and previous symbol)
+    double idealCABACctx = computeBinIndexEntropy(bitsGood, N);
+    auto cabacCtxStream  = cabacEncodeSymbols(symbols, BinarizationType::Good,
+                                              CabacContextMode::BinIndex);
+    auto cabacPrevStream = cabacEncodeSymbols(symbols, BinarizationType::Good,
+                                              CabacContextMode::BinIndexPrevSymbol);
+    bool okCabacCtx = cabacDecodeSymbols(cabacCtxStream) == symbols &&
+                      cabacDecodeSymbols(cabacPrevStream) == symbols;
+    double cabacCtxRate  = 8.0 * cabacCtxStream.size() / N;
+    double cabacPrevRate = 8.0 * cabacPrevStream.size() / N;
+
     // CABAC bad
-    auto bitsBad = binarizeSequence(symbols, BinarizationType::Bad);
+    auto bitsBad = binarizeSequencePacked(symbols, BinarizationType::Bad);
     double binsPerBad = double(bitsBad.size()) / N;
     double HbinBad = computeBinEntropy(bitsBad);
     double idealCABACbad = HbinBad * binsPerBad;
@@ -98,6 +121,51 @@ int main() {
     int ransBytes = int(ransStream.size());
     double ransRate = 8.0 * ransBytes / N;
 
+    auto ransX4Stream  = ransEncodeInterleaved(symbols, 4);
+    bool okRansX4      = (ransDecodeInterleaved(ransX4Stream) == symbols);
+    int ransX4Bytes    = int(ransX4Stream.size());
+
+    // Same x4 format from uint8_t and 2-bit packed input.
+    std::vector<uint8_t> decoded8(source.size());
+    auto ransX4Stream8 = ransEncodeInterleaved(source, 4);
+    ransDecodeInterleaved(ransX4Stream8.data(), ransX4Stream8.size(),
+                          decoded8.data(), decoded8.size());
+    auto packed = packSymbols2(source.data(), source.size());
+    std::vector<uint8_t> decodedPacked(packed.size());
+    auto ransPackedStream = ransEncodePacked2(packed.data(), source.size(), 4);
+    ransDecodePacked2(ransPackedStream.data(), ransPackedStream.size(),
+                      decodedPacked.data(), source.size());
+    bool okRansX4Compact = ransX4Stream8 == ransX4Stream && decoded8 == source &&
+                           ransPackedStream == ransX4Stream && decodedPacked == packed;
+
+    auto rans64Stream  = ransEncode64(symbols);
+    bool okRans64      = (ransDecode64(rans64Stream) == symbols);
+    int rans64Bytes    = int(rans64Stream.size());
+
+    auto ransO1Stream = ransEncodeOrder(symbols, 1);
+    auto ransO2Stream = ransEncodeOrder(symbols, 2);
+    bool okRansOrder  = ransDecodeOrder(ransO1Stream) == symbols &&
+                        ransDecodeOrder(ransO2Stream) == symbols;
+
+    auto ransSmallStream = ransEncodeSmall(symbols);
+    bool okRansSmall     = (ransDecodeSmall(ransSmallStream) == symbols);
+
+    auto ransAdaptStream = ransEncodeAdaptive(symbols);
+    bool okRansAdapt     = (ransDecodeAdaptive(ransAdaptStream) == symbols);
+    int ransAdaptBytes   = int(ransAdaptStream.size());
+
+    const CodecEstimate estimate = estimateCodecs(source.data(), source.size());
+
+    auto ransSimdStream = ransEncodeSimd(symbols, 32);
+    bool okRansSimd     = (ransDecodeSimd(ransSimdStream) == symbols);
+    int ransSimdBytes   = int(ransSimdStream.size());
+
+    // tANS
+    auto tansStream = tansEncode(symbols);
+    bool okTans     = (tansDecode(tansStream) == symbols);
+    int tansBytes   = int(tansStream.size());
+    double tansRate = 8.0 * tansBytes / N;
+
     // Pretty summary
     std::cout << "\n===================================================\n";
     std::cout << "                 ENTROPY SUMMARY\n";
@@ -114,7 +182,18 @@ int main() {
     std::cout << "CABAC-model LPS probability:         "
               << cabacModelP << " (state " << cabacState << ")\n";
     std::cout << "Difference:                          "
-              << std::abs(pLPS - cabacModelP) << "\n\n";
+              << std::abs(pLPS - cabacModelP) << "\n";
+    std::cout << "CABAC stream size:                   " << cabacBytes << " bytes\n";
+    std::cout << "CABAC rate:                          " << cabacRate << " bits/symbol\n";
+    std::cout << "roundtrip OK:                        " << std::boolalpha << okCabac << "\n\n";
+
+    std::cout << "---------------- CABAC (per-bin contexts) ---------\n";
+    std::cout << "ideal rate, bin-index contexts:      " << idealCABACctx << " bits/symbol\n";
+    std::cout << "bin-index contexts stream size:      " << cabacCtxStream.size() << " bytes\n";
+    std::cout << "bin-index contexts rate:             " << cabacCtxRate << " bits/symbol\n";
+    std::cout << "+ previous symbol stream size:       " << cabacPrevStream.size() << " bytes\n";
+    std::cout << "+ previous symbol rate:              " << cabacPrevRate << " bits/symbol\n";
+    std::cout << "roundtrip OK:                        " << okCabacCtx << "\n\n";
 
     std::cout << "---------------- CABAC (Bad) ----------------------\n";
     std::cout << "bins/symbol:                         " << binsPerBad << "\n";
@@ -124,12 +203,42 @@ int main() {
     std::cout << "---------------- rANS -----------------------------\n";
     std::cout << "rANS stream size:                    " << ransBytes << " bytes\n";
     std::cout << "rANS rate:                           " << ransRate << " bits/symbol\n";
-    std::cout << "roundtrip OK:                        " << std::boolalpha << okRans << "\n\n";
+    std::cout << "roundtrip OK:                        " << std::boolalpha << okRans << "\n";
+    std::cout << "rANS x4 interleaved size:            " << ransX4Bytes << " bytes\n";
+    std::cout << "rANS x4 roundtrip OK:                " << okRansX4 << "\n";
+    std::cout << "rANS x4 uint8/2-bit roundtrip OK:    " << okRansX4Compact << "\n";
+    std::cout << "rANS 64-bit state size:              " << rans64Bytes << " bytes\n";
+    std::cout << "rANS 64-bit state roundtrip OK:      " << okRans64 << "\n";
+    std::cout << "rANS order-1 / order-2 size:         " << ransO1Stream.size()
+              << " / " << ransO2Stream.size() << " bytes\n";
+    std::cout << "rANS order-1/2 roundtrip OK:         " << okRansOrder << "\n";
+    std::cout << "rANS small-message size:             " << ransSmallStream.size()
+              << " bytes (table " << int(ransSmallStream[0]) << ")\n";
+    std::cout << "rANS small-message roundtrip OK:     " << okRansSmall << "\n";
+    std::cout << "rANS adaptive size:                  " << ransAdaptBytes << " bytes\n";
+    std::cout << "rANS adaptive roundtrip OK:          " << okRansAdapt << "\n";
+    std::cout << "rANS x32 SIMD size:                  " << ransSimdBytes << " bytes\n";
+    std::cout << "rANS x32 SIMD roundtrip OK:          " << okRansSimd
+              << (ransSimdAvailable() ? " (avx2)" : " (scalar)") << "\n\n";
+
+    std::cout << "---------------- tANS -----------------------------\n";
+    std::cout << "tANS stream size:                    " << tansBytes << " bytes\n";
+    std::cout << "tANS rate:                           " << tansRate << " bits/symbol\n";
+    std::cout << "roundtrip OK:                        " << okTans << "\n\n";
 
     double diffRans = std::abs(ransRate - Hsym);
-    double diffCab  = std::abs(idealCABACgood - Hsym);
+    double diffCab  = std::abs(idealCABACctx - Hsym);
     std::string winner = (diffRans < diffCab ? "rANS" : "CABAC (good)");
 
+    std::cout << "---------------- Codec estimate -------------------\n";
+    std::cout << "estimated rANS order-0 / order-1:    " << estimate.size(CodecChoice::RansOrder0)
+              << " / " << estimate.size(CodecChoice::RansOrder1) << " bytes (actual "
+              << ransBytes << " / " << ransO1Stream.size() << ")\n";
+    std::cout << "estimated CABAC (+ previous symbol): " << estimate.size(CodecChoice::Cabac)
+              << " bytes (actual " << cabacPrevStream.size() << ")\n";
+    std::cout << "estimated raw:                       " << estimate.size(CodecChoice::Raw) << " bytes\n";
+    std::cout << "predicted best codec:                " << codecChoiceName(estimate.best) << "\n\n";
+
     std::cout << "===================================================\n";
     std::cout << "Winner (closest to entropy):          "
               << winner << "\n";
@@ -0,0 +1,88 @@
+#include "mapped_file.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define CODEC_HAVE_MMAP 1
+#endif
+
+MappedFile::MappedFile(const std::string& path) {
+#if defined(CODEC_HAVE_MMAP)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("MappedFile: cannot open " + path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("MappedFile: cannot stat " + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("MappedFile: mmap failed for " + path);
+        }
+        data_ = static_cast<const uint8_t*>(p);
+        mapped_ = true;
+    }
+    ::close(fd); // the mapping keeps the file alive
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("MappedFile: cannot open " + path);
+    }
+    fallback_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+#endif
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_), size_(other.size_), mapped_(other.mapped_),
+      fallback_(std::move(other.fallback_))
+{
+    if (!mapped_) data_ = fallback_.data();
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mapped_ = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = other.data_;
+        size_ = other.size_;
+        mapped_ = other.mapped_;
+        fallback_ = std::move(other.fallback_);
+        if (!mapped_) data_ = fallback_.data();
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_ = false;
+    }
+    return *this;
+}
+
+void MappedFile::release() {
+#if defined(CODEC_HAVE_MMAP)
+    if (mapped_) {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    fallback_.clear();
+}
@@ -1,239 +1,507 @@
 #include "rans.hpp"
+#include "rans_codec.hpp"
+#include "rans_model.hpp"
+#include "symbol_pack.hpp"
+#include "byte_io.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <functional>
 #include <stdexcept>
+#include <string>
 #include <vector>
-#include <numeric>
 
 namespace {
-    // rANS parameters
-    constexpr uint32_t RANS_L    = 1u << 23;   // renormalization lower bound
-    constexpr uint32_t TOTFREQ   = 1u << 12;   // total frequency (4096)
-    constexpr int      ALPH_SIZE = 4;
+    // The 4-symbol formats are the <4, 12, uint32_t, uint8_t> instance of
+    // the generic coder: byte renormalization with x in [2^23, 2^31).
+    using Codec = Rans4Codec;
 
-    // Little-endian helpers
-    void writeU32LE(std::vector<uint8_t>& out, uint32_t v) {
-        out.push_back(static_cast<uint8_t>( v        & 0xFFu));
-        out.push_back(static_cast<uint8_t>((v >> 8)  & 0xFFu));
-        out.push_back(static_cast<uint8_t>((v >> 16) & 0xFFu));
-        out.push_back(static_cast<uint8_t>((v >> 24) & 0xFFu));
+    constexpr uint32_t RANS_L     = Codec::L;
+    constexpr uint32_t SCALE_BITS = RANS_SCALE_BITS;
+    constexpr uint32_t TOTFREQ    = RANS_TOTFREQ;
+    constexpr int      ALPH_SIZE  = RANS_ALPH_SIZE;
+    constexpr int      MAX_LANES  = 8;
+
+    static_assert(Codec::TOTFREQ == TOTFREQ, "rANS model and codec disagree");
+
+    using EncTable = Codec::EncTable;
+
+    Codec::Model toCodecModel(const RansModel& m) {
+        Codec::Model c;
+        for (int k = 0; k < ALPH_SIZE; ++k) {
+            c.freq[k] = m.freq[k];
+            c.cum[k]  = m.cum[k];
+        }
+        return c;
     }
 
-    void writeU16LE(std::vector<uint8_t>& out, uint16_t v) {
-        out.push_back(static_cast<uint8_t>( v        & 0xFFu));
-        out.push_back(static_cast<uint8_t>((v >> 8)  & 0xFFu));
+    EncTable buildEncTable(const RansModel& m) {
+        EncTable t;
+        Codec::buildEncTable(toCodecModel(m), t);
+        return t;
     }
 
-    uint32_t readU32LE(const std::vector<uint8_t>& in, size_t& offset) {
-        if (offset + 4 > in.size()) {
-            throw std::runtime_error("ransDecode: truncated U32");
-        }
-        uint32_t v = 0;
-        v |= static_cast<uint32_t>(in[offset + 0]) << 0;
-        v |= static_cast<uint32_t>(in[offset + 1]) << 8;
-        v |= static_cast<uint32_t>(in[offset + 2]) << 16;
-        v |= static_cast<uint32_t>(in[offset + 3]) << 24;
-        offset += 4;
-        return v;
-    }
-
-    uint16_t readU16LE(const std::vector<uint8_t>& in, size_t& offset) {
-        if (offset + 2 > in.size()) {
-            throw std::runtime_error("ransDecode: truncated U16");
-        }
-        uint16_t v = 0;
-        v |= static_cast<uint16_t>(in[offset + 0]) << 0;
-        v |= static_cast<uint16_t>(in[offset + 1]) << 8;
-        offset += 2;
-        return v;
+    template <int L, class Src>
+    void encodeLanes(Src symbols, size_t n, const RansModel& m,
+                     std::vector<uint8_t>& out)
+    {
+        const EncTable e = buildEncTable(m);
+        Codec::encodeLanes<L>(symbols, n, e, out);
     }
-} // namespace
 
-// ==============================
-// rANS ENCODER
-// ==============================
+    template <int L, class Dst>
+    void decodeLanes(const uint8_t* stream, size_t size, size_t dataStart,
+                     const RansModel& m, Dst out, size_t n)
+    {
+        Codec::DecTable t;
+        Codec::buildDecTable(toCodecModel(m), t);
+        Codec::decodeLanes<L>(stream, dataStart, size, t, out, n);
+    }
 
-std::vector<uint8_t> ransEncode(const std::vector<int>& symbols) {
-    const uint32_t N = static_cast<uint32_t>(symbols.size());
-    if (N == 0) return {};
+    // Decode into a sink instead of an output buffer.
+    struct SinkDst {
+        const RansSymbolSink& sink;
+    };
+
+    template <int L>
+    void decodeLanes(const uint8_t* stream, size_t size, size_t dataStart,
+                     const RansModel& m, SinkDst dst, size_t n)
+    {
+        Codec::DecTable t;
+        Codec::buildDecTable(toCodecModel(m), t);
+        Codec::decodeLanesBatched<L, RANS_DECODE_BATCH>(stream, dataStart, size, t, n, dst.sink);
+    }
 
-    // 1) Build histogram
-    std::array<uint32_t, ALPH_SIZE> counts{0,0,0,0};
-    for (int s : symbols) {
-        if (s < 0 || s >= ALPH_SIZE) {
-            throw std::runtime_error("ransEncode: symbol out of range (0..3)");
+    // fn names the public entry point in error messages.
+    uint32_t checkedCount(const char* fn, const uint8_t* stream, size_t size,
+                          size_t minSize, size_t capacity, size_t& offset)
+    {
+        if (size < minSize) {
+            throw std::runtime_error(std::string(fn) + ": stream too short");
         }
-        counts[static_cast<size_t>(s)]++;
+        const uint32_t N = readU32LE(stream, size, offset);
+        if (N > capacity) {
+            throw std::runtime_error(std::string(fn) + ": output buffer too small");
+        }
+        return N;
     }
 
-    uint32_t sumCounts =
-        std::accumulate(counts.begin(), counts.end(), 0u);
-    if (sumCounts == 0) {
-        throw std::runtime_error("ransEncode: empty histogram");
+    // Shared by the int, uint8_t and 2-bit packed front ends; the model
+    // is built by the caller so each can histogram its own layout.
+    // The stream replaces out's contents; its capacity is kept, so a
+    // reused vector spares the allocation.
+    template <class Src>
+    void encodeSingle(Src symbols, size_t n, const RansModel& m,
+                      std::vector<uint8_t>& out)
+    {
+        // Header: N + freq[0..3]
+        out.clear();
+        out.reserve(16 + n);
+        writeU32LE(out, static_cast<uint32_t>(n));
+        ransWriteModel(out, m);
+
+        encodeLanes<1>(symbols, n, m, out);
     }
 
-    // 2) Normalize to TOTFREQ = 4096, ensure each freq >= 1
-    std::array<uint32_t, ALPH_SIZE> freqRaw{};
-    for (int k = 0; k < ALPH_SIZE; ++k) {
-        if (counts[k] == 0) {
-            freqRaw[k] = 1;
-        } else {
-            uint64_t scaled =
-                static_cast<uint64_t>(counts[k]) * TOTFREQ / sumCounts;
-            if (scaled == 0) scaled = 1;
-            freqRaw[k] = static_cast<uint32_t>(scaled);
-        }
+    template <class Src>
+    std::vector<uint8_t> encodeSingle(Src symbols, size_t n, const RansModel& m) {
+        std::vector<uint8_t> out;
+        encodeSingle(symbols, n, m, out);
+        return out;
     }
 
-    uint32_t sumFreq = 0;
-    for (int k = 0; k < ALPH_SIZE; ++k) sumFreq += freqRaw[k];
+    void checkLanes(int lanes) {
+        if (lanes != 1 && lanes != 2 && lanes != 4 && lanes != MAX_LANES) {
+            throw std::runtime_error("ransEncodeInterleaved: lanes must be 1, 2, 4 or 8");
+        }
+    }
 
-    if (sumFreq < TOTFREQ) {
-        freqRaw[0] += (TOTFREQ - sumFreq);
-    } else if (sumFreq > TOTFREQ) {
-        uint32_t diff = sumFreq - TOTFREQ;
-        while (diff > 0) {
-            int maxIdx = 0;
-            for (int k = 1; k < ALPH_SIZE; ++k) {
-                if (freqRaw[k] > freqRaw[maxIdx]) {
-                    maxIdx = k;
-                }
-            }
-            if (freqRaw[maxIdx] > 1) {
-                freqRaw[maxIdx]--;
-                diff--;
-            } else {
-                break;
-            }
+    template <class Src>
+    void encodeInterleaved(Src symbols, size_t n, const RansModel& m, int lanes,
+                           std::vector<uint8_t>& out)
+    {
+        // Header: N + lanes + freq[0..3]
+        out.clear();
+        out.reserve(16 + 4 * MAX_LANES + n);
+        writeU32LE(out, static_cast<uint32_t>(n));
+        out.push_back(static_cast<uint8_t>(lanes));
+        ransWriteModel(out, m);
+
+        switch (lanes) {
+            case 1: encodeLanes<1>(symbols, n, m, out); break;
+            case 2: encodeLanes<2>(symbols, n, m, out); break;
+            case 4: encodeLanes<4>(symbols, n, m, out); break;
+            default: encodeLanes<8>(symbols, n, m, out); break;
         }
     }
 
-    std::array<uint16_t, ALPH_SIZE> freq{};
-    for (int k = 0; k < ALPH_SIZE; ++k) {
-        if (freqRaw[k] == 0) freqRaw[k] = 1;
-        freq[k] = static_cast<uint16_t>(freqRaw[k]);
+    template <class Src>
+    std::vector<uint8_t> encodeInterleaved(Src symbols, size_t n, const RansModel& m,
+                                           int lanes)
+    {
+        std::vector<uint8_t> out;
+        encodeInterleaved(symbols, n, m, lanes, out);
+        return out;
     }
 
-    // 3) Build cumulative table
-    std::array<uint16_t, ALPH_SIZE> cum{};
-    cum[0] = 0;
-    for (int k = 1; k < ALPH_SIZE; ++k) {
-        cum[k] = static_cast<uint16_t>(cum[k-1] + freq[k-1]);
+    template <class Dst>
+    size_t decodeSingle(const uint8_t* stream, size_t size, Dst out, size_t capacity) {
+        size_t offset = 0;
+        const uint32_t N = checkedCount("ransDecode", stream, size, 12, capacity, offset);
+        RansModel m = ransReadModel(stream, size, offset);
+
+        decodeLanes<1>(stream, size, offset, m, out, N);
+        return N;
     }
-    // optional: assert that cum[3] + freq[3] == TOTFREQ
 
-    // 4) Write header: N + freq[0..3]
-    std::vector<uint8_t> out;
-    out.reserve(16 + symbols.size());
-    writeU32LE(out, N);
-    for (int k = 0; k < ALPH_SIZE; ++k) {
-        writeU16LE(out, freq[k]);
+    template <class Dst>
+    size_t decodeInterleaved(const uint8_t* stream, size_t size, Dst out,
+                             size_t capacity)
+    {
+        size_t offset = 0;
+        const uint32_t N = checkedCount("ransDecodeInterleaved", stream, size, 13,
+                                        capacity, offset);
+        int lanes = stream[offset++];
+        RansModel m = ransReadModel(stream, size, offset);
+
+        switch (lanes) {
+            case 1: decodeLanes<1>(stream, size, offset, m, out, N); break;
+            case 2: decodeLanes<2>(stream, size, offset, m, out, N); break;
+            case 4: decodeLanes<4>(stream, size, offset, m, out, N); break;
+            case 8: decodeLanes<8>(stream, size, offset, m, out, N); break;
+            default:
+                throw std::runtime_error("ransDecodeInterleaved: bad lane count in header");
+        }
+        return N;
     }
+} // namespace
 
-    // 5) rANS core
-    uint32_t x = RANS_L;
+// ==============================
+// rANS ENCODER
+// ==============================
 
-    // process symbols in reverse
-    for (int i = static_cast<int>(N) - 1; i >= 0; --i) {
-        int s = symbols[static_cast<size_t>(i)];
-        uint32_t f = freq[s];
-        uint32_t c = cum[s];
+std::vector<uint8_t> ransEncode(const std::vector<int>& symbols) {
+    if (symbols.empty()) return {};
+    return encodeSingle(symbols.data(), symbols.size(), ransBuildModel(symbols));
+}
 
-        // Renormalization
-        while (x >= (RANS_L >> 8) * f) {
-            out.push_back(static_cast<uint8_t>(x & 0xFFu));
-            x >>= 8;
-        }
+std::vector<uint8_t> ransEncode(const std::vector<uint8_t>& symbols) {
+    if (symbols.empty()) return {};
+    return encodeSingle(symbols.data(), symbols.size(),
+                        ransBuildModel(symbols.data(), symbols.size()));
+}
 
-        uint32_t q = x / f;
-        uint32_t r = x % f;
-        x = q * TOTFREQ + r + c;
-    }
+std::vector<uint8_t> ransEncodeInterleaved(const std::vector<int>& symbols,
+                                           int lanes)
+{
+    checkLanes(lanes);
+    if (symbols.empty()) return {};
+    return encodeInterleaved(symbols.data(), symbols.size(),
+                             ransBuildModel(symbols), lanes);
+}
 
-    // Flush final state (4 bytes, LSB-first)
-    for (int i = 0; i < 4; ++i) {
-        out.push_back(static_cast<uint8_t>(x & 0xFFu));
-        x >>= 8;
-    }
+std::vector<uint8_t> ransEncodeInterleaved(const std::vector<uint8_t>& symbols,
+                                           int lanes)
+{
+    checkLanes(lanes);
+    if (symbols.empty()) return {};
+    return encodeInterleaved(symbols.data(), symbols.size(),
+                             ransBuildModel(symbols.data(), symbols.size()), lanes);
+}
 
-    return out;
+void ransEncode(const int* symbols, size_t n, std::vector<uint8_t>& out) {
+    out.clear();
+    if (n == 0) return;
+    encodeSingle(symbols, n, ransBuildModel(symbols, n), out);
+}
+
+void ransEncode(const uint8_t* symbols, size_t n, std::vector<uint8_t>& out) {
+    out.clear();
+    if (n == 0) return;
+    encodeSingle(symbols, n, ransBuildModel(symbols, n), out);
+}
+
+void ransEncodeInterleaved(const int* symbols, size_t n, int lanes,
+                           std::vector<uint8_t>& out)
+{
+    checkLanes(lanes);
+    out.clear();
+    if (n == 0) return;
+    encodeInterleaved(symbols, n, ransBuildModel(symbols, n), lanes, out);
+}
+
+void ransEncodeInterleaved(const uint8_t* symbols, size_t n, int lanes,
+                           std::vector<uint8_t>& out)
+{
+    checkLanes(lanes);
+    out.clear();
+    if (n == 0) return;
+    encodeInterleaved(symbols, n, ransBuildModel(symbols, n), lanes, out);
+}
+
+std::vector<uint8_t> ransEncodePacked2(const uint8_t* packed, size_t n, int lanes) {
+    checkLanes(lanes);
+    if (n == 0) return {};
+    return encodeInterleaved(Packed2View{packed}, n,
+                             ransBuildModelPacked2(packed, n), lanes);
 }
 
 // ==============================
 // rANS DECODER
 // ==============================
 
+size_t ransDecodedSize(const uint8_t* stream, size_t size) {
+    size_t offset = 0;
+    return readU32LE(stream, size, offset);
+}
+
+size_t ransDecode(const uint8_t* stream, size_t size, int* out, size_t capacity) {
+    return decodeSingle(stream, size, out, capacity);
+}
+
+size_t ransDecode(const uint8_t* stream, size_t size, uint8_t* out, size_t capacity) {
+    return decodeSingle(stream, size, out, capacity);
+}
+
+size_t ransDecodeInterleaved(const uint8_t* stream, size_t size,
+                             int* out, size_t capacity)
+{
+    return decodeInterleaved(stream, size, out, capacity);
+}
+
+size_t ransDecodeInterleaved(const uint8_t* stream, size_t size,
+                             uint8_t* out, size_t capacity)
+{
+    return decodeInterleaved(stream, size, out, capacity);
+}
+
+size_t ransDecode(const uint8_t* stream, size_t size, const RansSymbolSink& sink) {
+    return decodeSingle(stream, size, SinkDst{sink}, SIZE_MAX);
+}
+
+size_t ransDecodeInterleaved(const uint8_t* stream, size_t size,
+                             const RansSymbolSink& sink)
+{
+    return decodeInterleaved(stream, size, SinkDst{sink}, SIZE_MAX);
+}
+
+size_t ransDecodePacked2(const uint8_t* stream, size_t size,
+                         uint8_t* packed, size_t capacity)
+{
+    // The sink ORs symbols in, so clear the bytes the header says we need.
+    if (size >= 4 && ransDecodedSize(stream, size) <= capacity) {
+        std::fill(packed, packed + packedSize2(ransDecodedSize(stream, size)), uint8_t(0));
+    }
+    return decodeInterleaved(stream, size, Packed2Sink{packed}, capacity);
+}
+
 std::vector<int> ransDecode(const std::vector<uint8_t>& stream) {
     if (stream.size() < 12) {
         throw std::runtime_error("ransDecode: stream too short");
     }
+    std::vector<int> out(ransDecodedSize(stream.data(), stream.size()));
+    ransDecode(stream.data(), stream.size(), out.data(), out.size());
+    return out;
+}
 
-    size_t offset = 0;
-    uint32_t N = readU32LE(stream, offset);
-
-    std::array<uint16_t, ALPH_SIZE> freq{};
-    for (int k = 0; k < ALPH_SIZE; ++k) {
-        freq[k] = readU16LE(stream, offset);
-        if (freq[k] == 0) {
-            throw std::runtime_error("ransDecode: zero freq in header");
-        }
+std::vector<int> ransDecodeInterleaved(const std::vector<uint8_t>& stream) {
+    if (stream.size() < 13) {
+        throw std::runtime_error("ransDecodeInterleaved: stream too short");
     }
+    std::vector<int> out(ransDecodedSize(stream.data(), stream.size()));
+    ransDecodeInterleaved(stream.data(), stream.size(), out.data(), out.size());
+    return out;
+}
 
-    const size_t dataStart = offset;
+// ==============================
+// 64-bit state
+// ==============================
 
-    std::array<uint16_t, ALPH_SIZE> cum{};
-    cum[0] = 0;
-    for (int k = 1; k < ALPH_SIZE; ++k) {
-        cum[k] = static_cast<uint16_t>(cum[k-1] + freq[k-1]);
-    }
-    uint32_t totalFreq = cum[ALPH_SIZE - 1] + freq[ALPH_SIZE - 1];
-    if (totalFreq != TOTFREQ) {
-        throw std::runtime_error("ransDecode: totalFreq != TOTFREQ");
-    }
+std::vector<uint8_t> ransEncode64(const std::vector<int>& symbols) {
+    return Rans64Codec::encode(symbols.data(), symbols.size());
+}
 
-    // Reconstruct final state x from the last 4 bytes (LSB-first)
-    size_t idx = stream.size();
-    if (idx < 4) {
-        throw std::runtime_error("ransDecode: not enough bytes for final state");
-    }
+std::vector<int> ransDecode64(const std::vector<uint8_t>& stream) {
+    return Rans64Codec::decodeAs<int>(stream);
+}
 
-    uint32_t x = 0;
-    for (int i = 0; i < 4; ++i) {
-        x |= static_cast<uint32_t>(stream[--idx]) << (8 * i);
-    }
+// ==============================
+// Byte / 16-bit alphabets
+// ==============================
 
-    std::vector<int> out(N);
+std::vector<uint8_t> ransEncodeBytes(const std::vector<uint8_t>& bytes) {
+    return RansByteCodec::encode(bytes.data(), bytes.size());
+}
+
+std::vector<uint8_t> ransDecodeBytes(const std::vector<uint8_t>& stream) {
+    return RansByteCodec::decode(stream);
+}
 
-    // Decode in reverse (i = N-1..0) to match encoder
-    for (int i = static_cast<int>(N) - 1; i >= 0; --i) {
-        // Split x into high+low parts w.r.t TOTFREQ
-        uint32_t x_mod = x % TOTFREQ;   // == r + c
-        uint32_t x_div = x / TOTFREQ;   // == q
+std::vector<uint8_t> ransEncode16(const std::vector<uint16_t>& values) {
+    return Rans16Codec::encode(values.data(), values.size());
+}
 
-        // Find symbol s such that cum[s] <= x_mod < cum[s] + freq[s]
-        int s = 0;
-        for (int k = 0; k < ALPH_SIZE; ++k) {
-            uint32_t c = cum[k];
-            uint32_t f = freq[k];
-            if (x_mod >= c && x_mod < c + f) {
-                s = k;
-                break;
+std::vector<uint16_t> ransDecode16(const std::vector<uint8_t>& stream) {
+    return Rans16Codec::decode(stream);
+}
+
+// ==============================
+// Adaptive rANS
+// ==============================
+//
+// Layout: N (u32), then per chunk of ADAPT_CHUNK symbols:
+//   chunkSize (u32) + final state (u32) + payload in decode order.
+// There is no frequency header. Both sides start from uniform counts,
+// update them with every symbol and rebuild the model every
+// ADAPT_INTERVAL symbols, so interval k is coded with the statistics of
+// everything before it. Over the first interval the model is also
+// rebuilt after 16, 32, 64, ... symbols, so short inputs do not spend
+// a whole interval on the uniform start. Counts are halved past
+// ADAPT_LIMIT so the model tracks drift. Chunks are flushed separately,
+// which lets the encoder gather a chunk's models while the chunk is
+// still in cache instead of sweeping the whole input first.
+
+namespace {
+    constexpr size_t   ADAPT_CHUNK    = size_t(1) << 14;
+    constexpr uint32_t ADAPT_INTERVAL = 1024;
+    constexpr uint32_t ADAPT_LIMIT    = 1u << 13;
+    constexpr size_t   ADAPT_RAMP     = 16;
+
+    // Whether the model is rebuilt before coding symbol i: at each power
+    // of two from ADAPT_RAMP up to ADAPT_INTERVAL, then every interval.
+    constexpr bool adaptiveRebuild(size_t i) {
+        return i >= ADAPT_INTERVAL ? i % ADAPT_INTERVAL == 0
+                                   : i >= ADAPT_RAMP && (i & (i - 1)) == 0;
+    }
+    static_assert(ADAPT_CHUNK % ADAPT_INTERVAL == 0,
+                  "chunks must start on a model rebuild");
+
+    struct AdaptiveCounts {
+        std::array<uint32_t, ALPH_SIZE> counts{1, 1, 1, 1};
+        uint32_t total = ALPH_SIZE;
+
+        void add(int s) {
+            counts[s]++;
+            if (++total >= ADAPT_LIMIT) {
+                total = 0;
+                for (auto& c : counts) {
+                    c = (c + 1) >> 1;
+                    total += c;
+                }
             }
         }
-        out[static_cast<size_t>(i)] = s;
+    };
+
+    // Four symbols: the slot search is three compares, so the decoder
+    // needs no slot table to rebuild at every model update.
+    inline int decodeAdaptiveSymbol(uint32_t& x, const std::vector<uint8_t>& stream,
+                                    size_t& idx, size_t end,
+                                    const RansModel& m)
+    {
+        const uint32_t slot = x & (TOTFREQ - 1);
+        const int s = (slot >= m.cum[1]) + (slot >= m.cum[2]) + (slot >= m.cum[3]);
+        x = m.freq[s] * (x >> SCALE_BITS) + slot - m.cum[s];
+
+        while (x < RANS_L && idx < end) {
+            x = (x << 8) | stream[idx++];
+        }
+        return s;
+    }
+} // namespace
+
+std::vector<uint8_t> ransEncodeAdaptive(const std::vector<int>& symbols) {
+    const uint32_t N = static_cast<uint32_t>(symbols.size());
+    if (N == 0) return {};
 
-        uint32_t c = cum[s];
-        uint32_t f = freq[s];
+    std::vector<uint8_t> out;
+    out.reserve(16 + symbols.size());
+    writeU32LE(out, N);
 
-        uint32_t x_rem = x_mod - c;   // == r
-        x = f * x_div + x_rem;        // recover previous x
+    AdaptiveCounts counts;
+    RansModel model = ransModelFromCounts(counts.counts);
+    std::vector<EncTable> tables;
+    std::vector<size_t> starts;
+    tables.reserve(ADAPT_CHUNK / ADAPT_INTERVAL + 8);
+    starts.reserve(ADAPT_CHUNK / ADAPT_INTERVAL + 8);
+
+    for (size_t lo = 0; lo < N; lo += ADAPT_CHUNK) {
+        const size_t hi = std::min<size_t>(N, lo + ADAPT_CHUNK);
+
+        // Forward: record each model and the first symbol it codes.
+        tables.clear();
+        starts.clear();
+        for (size_t i = lo; i < hi; ++i) {
+            const bool rebuild = adaptiveRebuild(i);
+            if (rebuild) model = ransModelFromCounts(counts.counts);
+            if (rebuild || i == lo) {
+                tables.push_back(buildEncTable(model));
+                starts.push_back(i);
+            }
+            const int s = symbols[i];
+            if (s < 0 || s >= ALPH_SIZE) {
+                throw std::runtime_error("ransEncode: symbol out of range (0..3)");
+            }
+            counts.add(s);
+        }
 
-        // Renormalization (inverse of encoder)
-        while (x < RANS_L && idx > dataStart) {
-            x = (x << 8) | stream[--idx];
+        // Backward: code the chunk as its own rANS stream.
+        const size_t sizePos = out.size();
+        writeU32LE(out, 0);
+        writeU32LE(out, 0);
+        const size_t base = out.size();
+        uint32_t x = RANS_L;
+        size_t t = tables.size() - 1;
+        for (size_t i = hi; i-- > lo; ) {
+            if (i < starts[t]) --t;
+            Codec::encodeSymbol(x, out, tables[t][symbols[i]]);
         }
+        Codec::reverseWords(out.data() + base, out.data() + out.size());
+        Codec::storeState(out.data() + sizePos + 4, x);
+
+        const uint32_t chunkSize = static_cast<uint32_t>(out.size() - sizePos - 4);
+        for (int b = 0; b < 4; ++b) {
+            out[sizePos + b] = static_cast<uint8_t>((chunkSize >> (8 * b)) & 0xFFu);
+        }
+    }
+    return out;
+}
+
+std::vector<int> ransDecodeAdaptive(const std::vector<uint8_t>& stream) {
+    size_t offset = 0;
+    const uint32_t N = readU32LE(stream, offset);
+
+    // Every chunk takes at least its size and state words (8 bytes), so a
+    // count the stream cannot hold is rejected before allocating for it.
+    const size_t chunks = (size_t(N) + ADAPT_CHUNK - 1) / ADAPT_CHUNK;
+    if (chunks > (stream.size() - offset) / 8) {
+        throw std::runtime_error("ransDecode: symbol count exceeds the stream");
     }
 
+    std::vector<int> out(N);
+    AdaptiveCounts counts;
+    RansModel model = ransModelFromCounts(counts.counts);
+
+    for (size_t lo = 0; lo < N; lo += ADAPT_CHUNK) {
+        const size_t hi = std::min<size_t>(N, lo + ADAPT_CHUNK);
+        const uint32_t chunkSize = readU32LE(stream, offset);
+        if (chunkSize < 4 || chunkSize > stream.size() - offset) {
+            throw std::runtime_error("ransDecode: truncated chunk");
+        }
+
+        const size_t end = offset + chunkSize;
+        size_t idx = offset;
+        uint32_t x = Codec::getState(stream.data(), idx);
+
+        for (size_t i = lo; i < hi; ++i) {
+            if (adaptiveRebuild(i)) {
+                model = ransModelFromCounts(counts.counts);
+            }
+            const int s = decodeAdaptiveSymbol(x, stream, idx, end, model);
+            out[i] = s;
+            counts.add(s);
+        }
+        offset += chunkSize;
+    }
     return out;
-}
\ No newline at end of file
+}
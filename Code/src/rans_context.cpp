@@ -0,0 +1,217 @@
+#include "rans.hpp"
+#include "rans_codec.hpp"
+#include "byte_io.hpp"
+#include "codec_trace.hpp"
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Order-1 / order-2 context models on the 64-bit engine: 16-bit
+// precision keeps skewed contexts accurate, and its compare-based decode
+// needs only freq/cum per context, so all 16 tables take 512 bytes.
+
+namespace {
+    using Codec = Rans64Codec;
+    using State = uint64_t;
+
+    constexpr size_t ALPH_SIZE    = 4;
+    constexpr size_t MAX_CONTEXTS = 16;
+
+    using Counts = RansTable<uint64_t, ALPH_SIZE>;
+
+    size_t contextCount(int order) { return size_t(1) << (2 * order); }
+
+    // Context of the next symbol given the two before it (0 before the
+    // start); order 1 drops the older one.
+    struct ContextTracker {
+        size_t mask;
+        size_t ctx = 0;
+
+        explicit ContextTracker(int order) : mask(contextCount(order) - 1) {}
+        void push(unsigned s) { ctx = ((ctx << 2) | s) & mask; }
+    };
+
+    void checkOrder(int order, const char* fn) {
+        if (order != 1 && order != 2) {
+            throw std::runtime_error(std::string(fn) + ": order must be 1 or 2");
+        }
+    }
+
+    // Compact table: K (varint) + K x (symbol gap, freq) varints, the last
+    // freq left out since the total is fixed.
+    void writeContextModel(std::vector<uint8_t>& out, const Codec::Model& m) {
+        size_t used = 0;
+        for (size_t k = 0; k < ALPH_SIZE; ++k) used += m.freq[k] != 0;
+        writeVarint(out, used);
+        size_t prev = 0;
+        size_t written = 0;
+        for (size_t k = 0; k < ALPH_SIZE; ++k) {
+            if (m.freq[k] == 0) continue;
+            writeVarint(out, k - prev);
+            if (++written < used) writeVarint(out, m.freq[k]);
+            prev = k + 1;
+        }
+    }
+
+    Codec::Model readContextModel(const uint8_t* in, size_t size, size_t& offset) {
+        Codec::Model m;
+        const uint64_t used = readVarint(in, size, offset);
+        if (used == 0 || used > ALPH_SIZE) {
+            throw std::runtime_error("ransDecodeOrder: bad frequency table");
+        }
+        uint64_t k = 0;
+        uint64_t total = 0;
+        for (uint64_t i = 0; i < used; ++i) {
+            k += readVarint(in, size, offset);
+            const uint64_t f = (i + 1 < used) ? readVarint(in, size, offset)
+                                              : Codec::TOTFREQ - total;
+            if (k >= ALPH_SIZE || f == 0 || total + f > Codec::TOTFREQ) {
+                throw std::runtime_error("ransDecodeOrder: bad frequency table");
+            }
+            m.freq[static_cast<size_t>(k)] = static_cast<uint32_t>(f);
+            total += f;
+            ++k;
+        }
+        Codec::buildCumulative(m);
+        return m;
+    }
+
+    // Layout: N (varint) + order (u8) + context mask (varint) + one
+    // compact table per context that occurs + final state + payload.
+    template <class Sym>
+    std::vector<uint8_t> encodeOrder(const Sym* symbols, size_t n, int order) {
+        checkOrder(order, "ransEncodeOrder");
+        if (n == 0) return {};
+        const size_t nCtx = contextCount(order);
+
+        std::array<Counts, MAX_CONTEXTS> counts{};
+        {
+            CODEC_STAGE(Histogram);
+            ContextTracker ctx(order);
+            for (size_t i = 0; i < n; ++i) {
+                const unsigned s = static_cast<unsigned>(symbols[i]);
+                if (s >= ALPH_SIZE) {
+                    throw std::runtime_error("ransEncodeOrder: symbol out of range (0..3)");
+                }
+                counts[ctx.ctx][s]++;
+                ctx.push(s);
+            }
+        }
+
+        std::vector<uint8_t> out;
+        out.reserve(24 + n / 2);
+        writeVarint(out, n);
+        out.push_back(static_cast<uint8_t>(order));
+
+        uint64_t mask = 0;
+        for (size_t c = 0; c < nCtx; ++c) {
+            for (size_t k = 0; k < ALPH_SIZE; ++k) {
+                if (counts[c][k] != 0) mask |= uint64_t(1) << c;
+            }
+        }
+        writeVarint(out, mask);
+
+        std::array<Codec::EncTable, MAX_CONTEXTS> enc;
+        for (size_t c = 0; c < nCtx; ++c) {
+            if (!(mask >> c & 1u)) continue;
+            const Codec::Model m = Codec::normalize(counts[c]);
+            writeContextModel(out, m);
+            Codec::buildEncTable(m, enc[c]);
+        }
+
+        // Reverse order so the decoder runs forward; the context of
+        // symbol i comes from symbols i - 1 and i - 2.
+        CODEC_STAGE(Encode);
+        CODEC_COUNT(RansEncodeSymbols, n);
+        const size_t start = out.size();
+        const size_t base = start + sizeof(State);
+        out.resize(base + (n + 1) * sizeof(uint32_t));
+        uint8_t* p = out.data() + base;
+        State x = Codec::L;
+        const size_t ctxMask = nCtx - 1;
+        for (size_t i = n; i-- > 0; ) {
+            size_t c = 0;
+            if (i >= 1) c = static_cast<size_t>(symbols[i - 1]);
+            if (i >= 2) c |= static_cast<size_t>(symbols[i - 2]) << 2;
+            const unsigned s = static_cast<unsigned>(symbols[i]);
+            Codec::encodeSymbol(x, p, enc[c & ctxMask][s]);
+        }
+        out.resize(static_cast<size_t>(p - out.data()));
+        CODEC_COUNT(RansWordsOut, (out.size() - base) / sizeof(uint32_t));
+        Codec::reverseWords(out.data() + base, out.data() + out.size());
+        Codec::storeState(out.data() + start, x);
+        CODEC_COUNT(RansBytesOut, out.size());
+        return out;
+    }
+
+    template <class Out>
+    size_t decodeOrder(const uint8_t* stream, size_t size, Out* out, size_t capacity) {
+        if (size == 0) return 0;
+        size_t offset = 0;
+        const uint64_t n = readVarint(stream, size, offset);
+        if (offset >= size) {
+            throw std::runtime_error("ransDecodeOrder: stream too short");
+        }
+        const int order = stream[offset++];
+        checkOrder(order, "ransDecodeOrder");
+        if (n > capacity) {
+            throw std::runtime_error("ransDecodeOrder: output buffer too small");
+        }
+        const size_t nCtx = contextCount(order);
+        const uint64_t mask = readVarint(stream, size, offset);
+        if (mask >> nCtx) {
+            throw std::runtime_error("ransDecodeOrder: bad context mask");
+        }
+
+        // Contexts that never occur keep an all-zero model; reaching one
+        // means the stream is corrupt, and decodeSymbol then yields a
+        // symbol without running out of bounds.
+        std::array<Codec::Model, MAX_CONTEXTS> dec{};
+        for (size_t c = 0; c < nCtx; ++c) {
+            if (mask >> c & 1u) dec[c] = readContextModel(stream, size, offset);
+        }
+
+        if (size < offset + sizeof(State)) {
+            throw std::runtime_error("ransDecodeOrder: not enough bytes for final state");
+        }
+        CODEC_STAGE(Decode);
+        CODEC_COUNT(RansDecodeSymbols, n);
+        size_t idx = offset;
+        State x = Codec::getState(stream, idx);
+        ContextTracker ctx(order);
+        for (size_t i = 0; i < n; ++i) {
+            const auto s = Codec::decodeSymbol(x, stream, idx, size, dec[ctx.ctx]);
+            out[i] = static_cast<Out>(s);
+            ctx.push(s);
+        }
+        CODEC_COUNT(RansWordsIn, (idx - offset - sizeof(State)) / sizeof(uint32_t));
+        return static_cast<size_t>(n);
+    }
+} // namespace
+
+std::vector<uint8_t> ransEncodeOrder(const std::vector<int>& symbols, int order) {
+    return encodeOrder(symbols.data(), symbols.size(), order);
+}
+
+std::vector<uint8_t> ransEncodeOrder(const std::vector<uint8_t>& symbols, int order) {
+    return encodeOrder(symbols.data(), symbols.size(), order);
+}
+
+std::vector<int> ransDecodeOrder(const std::vector<uint8_t>& stream) {
+    if (stream.empty()) return {};
+    size_t offset = 0;
+    std::vector<int> out(static_cast<size_t>(readVarint(stream, offset)));
+    ransDecodeOrder(stream.data(), stream.size(), out.data(), out.size());
+    return out;
+}
+
+size_t ransDecodeOrder(const uint8_t* stream, size_t size, int* out, size_t capacity) {
+    return decodeOrder(stream, size, out, capacity);
+}
+
+size_t ransDecodeOrder(const uint8_t* stream, size_t size, uint8_t* out, size_t capacity) {
+    return decodeOrder(stream, size, out, capacity);
+}
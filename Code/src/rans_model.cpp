@@ -0,0 +1,107 @@
+#include "rans_model.hpp"
+#include "byte_io.hpp"
+#include "codec_trace.hpp"
+#include "rans_normalize.hpp"
+#include "symbol_stats.hpp"
+
+#include <array>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+void ransBuildCumulative(RansModel& m) {
+    m.cum[0] = 0;
+    for (int k = 1; k < RANS_ALPH_SIZE; ++k) {
+        m.cum[k] = static_cast<uint16_t>(m.cum[k-1] + m.freq[k-1]);
+    }
+}
+
+// Histogram the input and normalize it to RANS_TOTFREQ = 4096, each freq >= 1.
+RansModel ransBuildModel(const std::vector<int>& symbols) {
+    return ransBuildModel(symbols.data(), symbols.size());
+}
+
+RansModel ransBuildModel(const int* symbols, size_t n) {
+    std::array<uint32_t, RANS_ALPH_SIZE> counts{0,0,0,0};
+    {
+        CODEC_STAGE(Histogram);
+        const SymbolHistogram h = symbolHistogram(symbols, n);
+        for (size_t k = 0; k < counts.size(); ++k) counts[k] = static_cast<uint32_t>(h.counts[k]);
+    }
+    return ransModelFromCounts(counts);
+}
+
+RansModel ransBuildModel(const uint8_t* symbols, size_t n) {
+    std::array<uint32_t, RANS_ALPH_SIZE> counts{0,0,0,0};
+    {
+        CODEC_STAGE(Histogram);
+        const SymbolHistogram h = symbolHistogram(symbols, n);
+        for (size_t k = 0; k < counts.size(); ++k) counts[k] = static_cast<uint32_t>(h.counts[k]);
+    }
+    return ransModelFromCounts(counts);
+}
+
+RansModel ransBuildModelPacked2(const uint8_t* packed, size_t n) {
+    std::array<uint32_t, RANS_ALPH_SIZE> counts{0,0,0,0};
+    {
+        CODEC_STAGE(Histogram);
+        // Histogram whole bytes, then split each byte value into its
+        // four symbols once.
+        std::array<uint32_t, 256> h{};
+        const size_t full = n / 4;
+        for (size_t b = 0; b < full; ++b) h[packed[b]]++;
+
+        for (int v = 0; v < 256; ++v) {
+            for (int k = 0; k < 4; ++k) counts[(v >> (2 * k)) & 3] += h[v];
+        }
+        for (size_t i = 4 * full; i < n; ++i) {
+            counts[(packed[i >> 2] >> (2 * (i & 3))) & 3]++;
+        }
+    }
+    return ransModelFromCounts(counts);
+}
+
+RansModel ransModelFromCounts(const std::array<uint32_t, RANS_ALPH_SIZE>& counts) {
+    CODEC_STAGE(Normalize);
+    uint32_t sumCounts =
+        std::accumulate(counts.begin(), counts.end(), 0u);
+    if (sumCounts == 0) {
+        throw std::runtime_error("ransEncode: empty histogram");
+    }
+
+    // The header has no way to mark a symbol absent, so each keeps a slot.
+    const std::array<uint64_t, RANS_ALPH_SIZE> wide{counts[0], counts[1], counts[2], counts[3]};
+    std::array<uint32_t, RANS_ALPH_SIZE> freq{};
+    ransNormalizeFreqs(wide.data(), wide.size(), RANS_TOTFREQ, freq.data(), true);
+
+    RansModel m;
+    for (int k = 0; k < RANS_ALPH_SIZE; ++k) m.freq[k] = static_cast<uint16_t>(freq[k]);
+    ransBuildCumulative(m);
+    return m;
+}
+
+void ransWriteModel(std::vector<uint8_t>& out, const RansModel& m) {
+    for (int k = 0; k < RANS_ALPH_SIZE; ++k) {
+        writeU16LE(out, m.freq[k]);
+    }
+}
+
+RansModel ransReadModel(const std::vector<uint8_t>& stream, size_t& offset) {
+    return ransReadModel(stream.data(), stream.size(), offset);
+}
+
+RansModel ransReadModel(const uint8_t* stream, size_t size, size_t& offset) {
+    RansModel m;
+    for (int k = 0; k < RANS_ALPH_SIZE; ++k) {
+        m.freq[k] = readU16LE(stream, size, offset);
+        if (m.freq[k] == 0) {
+            throw std::runtime_error("ransDecode: zero freq in header");
+        }
+    }
+    ransBuildCumulative(m);
+    uint32_t totalFreq = m.cum[RANS_ALPH_SIZE - 1] + m.freq[RANS_ALPH_SIZE - 1];
+    if (totalFreq != RANS_TOTFREQ) {
+        throw std::runtime_error("ransDecode: totalFreq != TOTFREQ");
+    }
+    return m;
+}
@@ -0,0 +1,126 @@
+#include "rans_normalize.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    struct Slot {
+        uint64_t count;
+        uint32_t freq;
+        uint32_t sym;
+    };
+
+    // Heap orders: the top is the symbol that gains most from one more
+    // slot, count / (freq + 1/2), or loses least from giving one up,
+    // count / (freq - 1/2). Counts stay below 2^32 and freq below 2^24,
+    // so the cross products fit in 64 bits.
+    struct GrowOrder {
+        bool operator()(const Slot& a, const Slot& b) const {
+            const uint64_t ka = a.count * (2 * uint64_t(b.freq) + 1);
+            const uint64_t kb = b.count * (2 * uint64_t(a.freq) + 1);
+            if (ka != kb) return ka < kb;
+            return a.sym > b.sym;
+        }
+    };
+
+    struct ShrinkOrder {
+        bool operator()(const Slot& a, const Slot& b) const {
+            const uint64_t ka = a.count * (2 * uint64_t(b.freq) - 1);
+            const uint64_t kb = b.count * (2 * uint64_t(a.freq) - 1);
+            if (ka != kb) return ka > kb;
+            return a.sym > b.sym;
+        }
+    };
+
+    // Move `steps` slots one at a time, re-heaping the symbol each time.
+    template <class Order>
+    void rebalance(Slot* heap, size_t size, uint64_t steps, int delta, uint32_t* freq) {
+        const Order order;
+        std::make_heap(heap, heap + size, order);
+        for (; steps > 0; --steps) {
+            std::pop_heap(heap, heap + size, order);
+            Slot& s = heap[size - 1];
+            s.freq = static_cast<uint32_t>(static_cast<int64_t>(s.freq) + delta);
+            freq[s.sym] = s.freq;
+            if (delta < 0 && s.freq == 1) {
+                --size; // cannot shrink below one slot
+            } else {
+                std::push_heap(heap, heap + size, order);
+            }
+        }
+    }
+} // namespace
+
+void ransNormalizeFreqs(const uint64_t* counts, size_t n, uint32_t totFreq,
+                        uint32_t* freq, bool keepAbsent)
+{
+    if (totFreq == 0 || totFreq > (1u << 24)) {
+        throw std::runtime_error("ransNormalizeFreqs: totFreq must be in 1..2^24");
+    }
+
+    uint64_t total = 0;
+    size_t used = 0;
+    for (size_t k = 0; k < n; ++k) {
+        total += counts[k];
+        used += counts[k] != 0;
+    }
+    if (used == 0) throw std::runtime_error("ransNormalizeFreqs: empty histogram");
+
+    const uint64_t reserved = keepAbsent ? n - used : 0;
+    if (used + reserved > totFreq) {
+        throw std::runtime_error("ransNormalizeFreqs: more symbols than frequency slots");
+    }
+    const uint64_t avail = totFreq - reserved;
+
+    // Keep the total (and so every count) below 2^31; symbols that
+    // occur keep a count of at least 1.
+    int shift = 0;
+    while ((total >> shift) + used >= (uint64_t(1) << 31)) ++shift;
+    if (shift > 0) {
+        total = 0;
+        for (size_t k = 0; k < n; ++k) {
+            if (counts[k] != 0) total += std::max<uint64_t>(1, counts[k] >> shift);
+        }
+    }
+
+    // Round c * avail / total to nearest through a fixed-point
+    // reciprocal (which may come out one low): that is where the size
+    // stops falling at the continuous optimum, so only the sum is off,
+    // by about sqrt(n) slots.
+    const uint64_t rcp = (avail << 32) / total;
+
+    std::array<Slot, 256> local;
+    std::vector<Slot> spill;
+    Slot* slots = local.data();
+    if (used > local.size()) {
+        spill.resize(used);
+        slots = spill.data();
+    }
+
+    uint64_t sum = 0;
+    size_t m = 0;
+    for (size_t k = 0; k < n; ++k) {
+        if (counts[k] == 0) {
+            freq[k] = keepAbsent ? 1 : 0;
+            continue;
+        }
+        const uint64_t c = shift ? std::max<uint64_t>(1, counts[k] >> shift) : counts[k];
+        const uint32_t f = static_cast<uint32_t>(std::max<uint64_t>(1, (c * rcp + (uint64_t(1) << 31)) >> 32));
+        freq[k] = f;
+        sum += f;
+        slots[m++] = Slot{c, f, static_cast<uint32_t>(k)};
+    }
+
+    if (sum < avail) {
+        rebalance<GrowOrder>(slots, m, avail - sum, +1, freq);
+    } else if (sum > avail) {
+        // avail >= used, so the symbols above one slot have enough to spare.
+        size_t shrinkable = 0;
+        for (size_t i = 0; i < m; ++i) {
+            if (slots[i].freq > 1) slots[shrinkable++] = slots[i];
+        }
+        rebalance<ShrinkOrder>(slots, shrinkable, sum - avail, -1, freq);
+    }
+}
@@ -0,0 +1,390 @@
+#include "rans.hpp"
+#include "rans_model.hpp"
+#include "byte_io.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define RANS_SIMD_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define RANS_AVX2_TARGET
+    #else
+        #define RANS_AVX2_TARGET __attribute__((target("avx2")))
+    #endif
+#endif
+
+// ==============================
+// Word-renormalized interleaved rANS
+// ==============================
+//
+// Layout: N (u32) + lanes (u8) + freq[0..3] (u16) + lane states (u32 each)
+// + 16-bit words in decode order. States live in [WORD_L, 2^32), so each
+// symbol needs at most one 16-bit renormalization step, which is what
+// makes a branch-free lane-parallel decoder possible.
+
+namespace {
+    constexpr uint32_t WORD_L     = 1u << 16;
+    constexpr uint32_t SCALE_BITS = RANS_SCALE_BITS;
+    constexpr uint32_t TOTFREQ    = RANS_TOTFREQ;
+    constexpr int      SIMD_WIDTH = 8; // 32-bit lanes per AVX2 register
+
+    inline bool validLanes(int lanes) {
+        return lanes == 8 || lanes == 16 || lanes == 32;
+    }
+
+    inline void encodeWordSymbol(uint32_t& x, std::vector<uint16_t>& words,
+                                 const RansModel& m, int s)
+    {
+        const uint32_t f = m.freq[s];
+        const uint32_t xMax = ((WORD_L >> SCALE_BITS) << 16) * f;
+        if (x >= xMax) {
+            words.push_back(static_cast<uint16_t>(x & 0xFFFFu));
+            x >>= 16;
+        }
+        x = (x / f) * TOTFREQ + (x % f) + m.cum[s];
+    }
+
+    // Slot table entry: freq (bits 0..12) | cum << 16 | symbol << 28.
+    void buildSlotTable(const RansModel& m, std::vector<uint32_t>& tab) {
+        tab.resize(TOTFREQ);
+        for (int k = 0; k < RANS_ALPH_SIZE; ++k) {
+            const uint32_t lo = m.cum[k];
+            const uint32_t hi = lo + m.freq[k];
+            const uint32_t packed = m.freq[k] | (lo << 16)
+                                  | (static_cast<uint32_t>(k) << 28);
+            std::fill(tab.begin() + lo, tab.begin() + hi, packed);
+        }
+    }
+
+    // Parsed stream: everything the kernels need.
+    struct WordStream {
+        uint32_t N = 0;
+        int lanes = 0;
+        std::vector<uint32_t> slotTab;
+        std::array<uint32_t, 32> x{};
+        const uint8_t* words = nullptr; // u16 LE
+        size_t nWords = 0;
+    };
+
+    WordStream parseWordStream(const uint8_t* stream, size_t size) {
+        WordStream ws;
+        size_t offset = 0;
+        ws.N = readU32LE(stream, size, offset);
+        if (offset >= size) {
+            throw std::runtime_error("ransDecodeSimd: stream too short");
+        }
+        ws.lanes = stream[offset++];
+        if (!validLanes(ws.lanes)) {
+            throw std::runtime_error("ransDecodeSimd: bad lane count in header");
+        }
+        RansModel m = ransReadModel(stream, size, offset);
+        buildSlotTable(m, ws.slotTab);
+        for (int j = 0; j < ws.lanes; ++j) {
+            ws.x[j] = readU32LE(stream, size, offset);
+        }
+        ws.words  = stream + offset;
+        ws.nWords = (size - offset) / 2;
+        return ws;
+    }
+
+    inline uint32_t loadWord(const WordStream& ws, size_t pos) {
+        if (pos >= ws.nWords) {
+            throw std::runtime_error("ransDecodeSimd: truncated payload");
+        }
+        return ws.words[2 * pos] | (static_cast<uint32_t>(ws.words[2 * pos + 1]) << 8);
+    }
+
+    inline int decodeWordSymbol(uint32_t& x, const WordStream& ws, size_t& pos) {
+        const uint32_t slot = x & (TOTFREQ - 1);
+        const uint32_t e    = ws.slotTab[slot];
+        x = (e & 0x1FFFu) * (x >> SCALE_BITS) + slot - ((e >> 16) & 0xFFFu);
+        if (x < WORD_L) {
+            x = (x << 16) | loadWord(ws, pos++);
+        }
+        return static_cast<int>(e >> 28);
+    }
+
+    // Scalar reference decoder for groups [0, groups); also used for the tail.
+    template <class Out>
+    void decodeGroupsScalar(WordStream& ws, size_t groups, size_t& pos,
+                            Out* out)
+    {
+        const int L = ws.lanes;
+        for (size_t g = 0; g < groups; ++g) {
+            Out* o = out + g * L;
+            for (int j = 0; j < L; ++j) {
+                o[j] = static_cast<Out>(decodeWordSymbol(ws.x[j], ws, pos));
+            }
+        }
+    }
+
+#if defined(RANS_SIMD_X86)
+    bool cpuHasAvx2() {
+    #if defined(_MSC_VER) && !defined(__clang__)
+        int r[4];
+        __cpuid(r, 0);
+        if (r[0] < 7) return false;
+        __cpuid(r, 1);
+        const bool osxsave = (r[2] & (1 << 27)) != 0;
+        const bool avx     = (r[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+        __cpuidex(r, 7, 0);
+        return (r[1] & (1 << 5)) != 0;
+    #else
+        return __builtin_cpu_supports("avx2");
+    #endif
+    }
+
+    // For each 8-bit renormalization mask: which incoming word each lane
+    // takes (its rank among the set lanes) and how many words are consumed.
+    struct ExpandTable {
+        alignas(32) uint32_t idx[256][SIMD_WIDTH];
+        uint8_t count[256];
+
+        ExpandTable() {
+            for (int mask = 0; mask < 256; ++mask) {
+                uint32_t rank = 0;
+                for (int j = 0; j < SIMD_WIDTH; ++j) {
+                    idx[mask][j] = rank;
+                    if (mask & (1 << j)) ++rank;
+                }
+                count[mask] = static_cast<uint8_t>(rank);
+            }
+        }
+    };
+
+    const ExpandTable& expandTable() {
+        static const ExpandTable t;
+        return t;
+    }
+
+    // Full groups only; every AVX2 register holds 8 consecutive lanes and
+    // registers renormalize in lane order, matching the scalar decoder.
+    RANS_AVX2_TARGET
+    inline void storeSymbols(int* o, __m256i sym) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), sym);
+    }
+
+    // Narrow eight 32-bit symbols to bytes: low byte of each dword, then
+    // the two 128-bit halves side by side.
+    RANS_AVX2_TARGET
+    inline void storeSymbols(uint8_t* o, __m256i sym) {
+        const __m256i pick = _mm256_setr_epi8(
+            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m256i b = _mm256_shuffle_epi8(sym, pick);
+        const uint32_t lo = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm256_castsi256_si128(b)));
+        const uint32_t hi = static_cast<uint32_t>(_mm256_extract_epi32(b, 4));
+        std::memcpy(o, &lo, 4);
+        std::memcpy(o + 4, &hi, 4);
+    }
+
+    template <class Out>
+    RANS_AVX2_TARGET
+    void decodeGroupsAvx2(WordStream& ws, size_t groups, size_t& pos,
+                          Out* out)
+    {
+        const ExpandTable& et = expandTable();
+        const int regs = ws.lanes / SIMD_WIDTH;
+        const int* tab = reinterpret_cast<const int*>(ws.slotTab.data());
+
+        const __m256i slotMask = _mm256_set1_epi32(TOTFREQ - 1);
+        const __m256i freqMask = _mm256_set1_epi32(0x1FFF);
+        const __m256i cumMask  = _mm256_set1_epi32(0xFFF);
+        const __m256i zero     = _mm256_setzero_si256();
+
+        __m256i x[4];
+        for (int r = 0; r < regs; ++r) {
+            x[r] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ws.x.data() + SIMD_WIDTH * r));
+        }
+
+        for (size_t g = 0; g < groups; ++g) {
+            Out* o = out + g * ws.lanes;
+            for (int r = 0; r < regs; ++r) {
+                __m256i slot = _mm256_and_si256(x[r], slotMask);
+                __m256i e    = _mm256_i32gather_epi32(tab, slot, 4);
+                __m256i freq = _mm256_and_si256(e, freqMask);
+                __m256i cum  = _mm256_and_si256(_mm256_srli_epi32(e, 16), cumMask);
+                __m256i sym  = _mm256_srli_epi32(e, 28);
+                storeSymbols(o + SIMD_WIDTH * r, sym);
+
+                __m256i xv = _mm256_mullo_epi32(freq, _mm256_srli_epi32(x[r], SCALE_BITS));
+                xv = _mm256_sub_epi32(_mm256_add_epi32(xv, slot), cum);
+
+                // Lanes below WORD_L pull the next words in lane order.
+                __m256i need = _mm256_cmpeq_epi32(_mm256_srli_epi32(xv, 16), zero);
+                int mask = _mm256_movemask_ps(_mm256_castsi256_ps(need));
+                __m128i raw;
+                if (pos + SIMD_WIDTH <= ws.nWords) {
+                    raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ws.words + 2 * pos));
+                } else {
+                    alignas(16) uint16_t tmp[SIMD_WIDTH] = {};
+                    const size_t n = et.count[mask];
+                    for (size_t k = 0; k < n; ++k) {
+                        tmp[k] = static_cast<uint16_t>(loadWord(ws, pos + k));
+                    }
+                    raw = _mm_load_si128(reinterpret_cast<const __m128i*>(tmp));
+                }
+                __m256i w = _mm256_cvtepu16_epi32(raw);
+                __m256i perm = _mm256_load_si256(reinterpret_cast<const __m256i*>(et.idx[mask]));
+                w = _mm256_permutevar8x32_epi32(w, perm);
+                __m256i shifted = _mm256_or_si256(_mm256_slli_epi32(xv, 16), w);
+                xv = _mm256_blendv_epi8(xv, shifted, need);
+                pos += et.count[mask];
+                x[r] = xv;
+            }
+        }
+
+        for (int r = 0; r < regs; ++r) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(ws.x.data() + SIMD_WIDTH * r), x[r]);
+        }
+    }
+#endif
+} // namespace
+
+// ==============================
+// Encoder
+// ==============================
+
+namespace {
+    template <class Sym>
+    std::vector<uint8_t> encodeSimd(const Sym* symbols, size_t n,
+                                    const RansModel& m, int lanes)
+    {
+        const uint32_t N = static_cast<uint32_t>(n);
+        std::vector<uint32_t> x(static_cast<size_t>(lanes), WORD_L);
+        std::vector<uint16_t> words;
+        words.reserve(n / 2 + 16);
+
+        // Reverse of the decode order: tail first, then groups back to front.
+        const size_t L = static_cast<size_t>(lanes);
+        const size_t full = N - N % L;
+        for (size_t i = N; i-- > full; ) {
+            encodeWordSymbol(x[i % L], words, m, symbols[i]);
+        }
+        for (size_t g = full; g > 0; g -= L) {
+            for (size_t j = L; j-- > 0; ) {
+                encodeWordSymbol(x[j], words, m, symbols[g - L + j]);
+            }
+        }
+
+        std::vector<uint8_t> out;
+        out.reserve(11 + 4 * L + 2 * words.size());
+        writeU32LE(out, N);
+        out.push_back(static_cast<uint8_t>(lanes));
+        ransWriteModel(out, m);
+        for (size_t j = 0; j < L; ++j) {
+            writeU32LE(out, x[j]);
+        }
+        for (size_t k = words.size(); k-- > 0; ) {
+            writeU16LE(out, words[k]);
+        }
+        return out;
+    }
+} // namespace
+
+std::vector<uint8_t> ransEncodeSimd(const std::vector<int>& symbols, int lanes) {
+    return ransEncodeSimd(symbols.data(), symbols.size(), lanes);
+}
+
+std::vector<uint8_t> ransEncodeSimd(const std::vector<uint8_t>& symbols, int lanes) {
+    return ransEncodeSimd(symbols.data(), symbols.size(), lanes);
+}
+
+std::vector<uint8_t> ransEncodeSimd(const int* symbols, size_t n, int lanes) {
+    if (!validLanes(lanes)) {
+        throw std::runtime_error("ransEncodeSimd: lanes must be 8, 16 or 32");
+    }
+    if (n == 0) return {};
+    return encodeSimd(symbols, n, ransBuildModel(symbols, n), lanes);
+}
+
+std::vector<uint8_t> ransEncodeSimd(const uint8_t* symbols, size_t n, int lanes) {
+    if (!validLanes(lanes)) {
+        throw std::runtime_error("ransEncodeSimd: lanes must be 8, 16 or 32");
+    }
+    if (n == 0) return {};
+    return encodeSimd(symbols, n, ransBuildModel(symbols, n), lanes);
+}
+
+// ==============================
+// Decoder
+// ==============================
+
+bool ransSimdAvailable() {
+#if defined(RANS_SIMD_X86)
+    static const bool avx2 = cpuHasAvx2();
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+std::vector<int> ransDecodeSimd(const std::vector<uint8_t>& stream,
+                                RansDecodeKernel kernel)
+{
+    std::vector<int> out(ransDecodedSize(stream.data(), stream.size()));
+    ransDecodeSimd(stream.data(), stream.size(), out.data(), out.size(), kernel);
+    return out;
+}
+
+namespace {
+    template <class Out>
+    size_t decodeSimd(const uint8_t* stream, size_t size, Out* out,
+                      size_t capacity, RansDecodeKernel kernel)
+    {
+        WordStream ws = parseWordStream(stream, size);
+        if (ws.N > capacity) {
+            throw std::runtime_error("ransDecodeSimd: output buffer too small");
+        }
+
+        bool useAvx2 = false;
+        if (kernel == RansDecodeKernel::Avx2) {
+            if (!ransSimdAvailable()) {
+                throw std::runtime_error("ransDecodeSimd: AVX2 kernel not available");
+            }
+            useAvx2 = true;
+        } else if (kernel == RansDecodeKernel::Auto) {
+            useAvx2 = ransSimdAvailable();
+        }
+
+        const size_t L = static_cast<size_t>(ws.lanes);
+        const size_t groups = ws.N / L;
+        size_t pos = 0;
+
+#if defined(RANS_SIMD_X86)
+        if (useAvx2) {
+            decodeGroupsAvx2(ws, groups, pos, out);
+        } else {
+            decodeGroupsScalar(ws, groups, pos, out);
+        }
+#else
+        (void)useAvx2;
+        decodeGroupsScalar(ws, groups, pos, out);
+#endif
+
+        for (size_t i = groups * L; i < ws.N; ++i) {
+            out[i] = static_cast<Out>(decodeWordSymbol(ws.x[i % L], ws, pos));
+        }
+        return ws.N;
+    }
+} // namespace
+
+size_t ransDecodeSimd(const uint8_t* stream, size_t size, int* out,
+                      size_t capacity, RansDecodeKernel kernel)
+{
+    return decodeSimd(stream, size, out, capacity, kernel);
+}
+
+size_t ransDecodeSimd(const uint8_t* stream, size_t size, uint8_t* out,
+                      size_t capacity, RansDecodeKernel kernel)
+{
+    return decodeSimd(stream, size, out, capacity, kernel);
+}
@@ -0,0 +1,340 @@
+#include "rans.hpp"
+#include "rans_codec.hpp"
+#include "byte_io.hpp"
+#include "codec_trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Small-message format on the 64-bit engine.
+//
+// Layout: table id (u8) + N (varint) + [c0, c1, c2 (varints) when the
+// id is RANS_SMALL_INLINE; c3 = N - c0 - c1 - c2] + final state (k
+// bytes, LE) + payload (u32 words in decode order).
+//
+// The encoder starts from x = 1 rather than L. Renormalization only
+// emits once x >= 2^47 * f, far above L = 2^31, so no word is written
+// while x is still below L, and the decoder, which only pulls a word
+// when x < L and words remain, stays in step over that start-up stretch.
+// The final state therefore holds just the information coded so far
+// and is flushed in its significant bytes. The byte count k is implied
+// by the length after the header: with no payload words the tail is
+// the state itself (1..8 bytes); with words, k is raised to at least 5
+// so that tail = 4 * words + k (>= 9) identifies k as 5 + (tail - 5) % 4.
+// The decoder ends on x == 1 with every word consumed, which catches
+// most corruption.
+
+namespace {
+    using Codec = Rans64Codec;
+    using State = uint64_t;
+
+    constexpr size_t ALPH_SIZE  = 4;
+    constexpr int    MAX_TABLES = 256;
+
+    using Counts = RansTable<uint64_t, ALPH_SIZE>;
+
+    struct SmallModel {
+        Codec::Model    model;
+        Codec::EncTable enc;
+        std::array<double, ALPH_SIZE> bits{}; // -log2(p) per symbol, for RANS_SMALL_AUTO
+    };
+
+    SmallModel makeSmallModel(const Counts& counts) {
+        SmallModel m;
+        m.model = Codec::normalize(counts);
+        Codec::buildEncTable(m.model, m.enc);
+        for (size_t k = 0; k < ALPH_SIZE; ++k) {
+            m.bits[k] = m.model.freq[k]
+                      ? std::log2(double(Codec::TOTFREQ) / m.model.freq[k])
+                      : std::numeric_limits<double>::infinity();
+        }
+        return m;
+    }
+
+    // Slots are filled once and published through count with release
+    // order, so lookups take no lock; registration is serialized.
+    struct Registry {
+        std::array<SmallModel, MAX_TABLES> tables;
+        std::atomic<int> count{0};
+        std::mutex mutex;
+
+        Registry() {
+            static const uint64_t builtin[][ALPH_SIZE] = {
+                {25, 25, 25, 25},        // RANS_SMALL_UNIFORM
+                {70, 10, 10, 10},        // RANS_SMALL_P70
+                {40, 30, 20, 10},        // RANS_SMALL_LINEAR
+                {97, 1, 1, 1},           // RANS_SMALL_P97
+                {9990, 4, 4, 2},         // RANS_SMALL_P999
+            };
+            int n = RANS_SMALL_INLINE + 1;
+            for (const auto& c : builtin) {
+                Counts counts;
+                for (size_t k = 0; k < ALPH_SIZE; ++k) counts[k] = c[k];
+                tables[static_cast<size_t>(n++)] = makeSmallModel(counts);
+            }
+            count.store(n, std::memory_order_release);
+        }
+    };
+
+    Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    const SmallModel& tableModel(int id, const char* fn) {
+        Registry& r = registry();
+        if (id <= RANS_SMALL_INLINE || id >= r.count.load(std::memory_order_acquire)) {
+            throw std::runtime_error(std::string(fn) + ": unknown table id");
+        }
+        return r.tables[static_cast<size_t>(id)];
+    }
+
+    template <class Sym>
+    Counts histogram(const Sym* symbols, size_t n) {
+        CODEC_STAGE(Histogram);
+        Counts counts;
+        for (size_t i = 0; i < n; ++i) {
+            const unsigned s = static_cast<unsigned>(symbols[i]);
+            if (s >= ALPH_SIZE) {
+                throw std::runtime_error("ransEncodeSmall: symbol out of range (0..3)");
+            }
+            counts[s]++;
+        }
+        return counts;
+    }
+
+    size_t varintSize(uint64_t v) {
+        size_t n = 1;
+        while (v >= 0x80u) { v >>= 7; ++n; }
+        return n;
+    }
+
+    // Estimated payload plus table bits for each candidate; the inline
+    // model is costed at its empirical entropy and count bytes.
+    int pickTable(const Counts& counts, uint64_t n) {
+        double best = 0.0;
+        for (size_t k = 0; k < ALPH_SIZE; ++k) {
+            if (counts[k]) best += double(counts[k]) * std::log2(double(n) / double(counts[k]));
+        }
+        for (size_t k = 0; k + 1 < ALPH_SIZE; ++k) best += 8.0 * double(varintSize(counts[k]));
+        int pick = RANS_SMALL_INLINE;
+
+        Registry& r = registry();
+        const int count = r.count.load(std::memory_order_acquire);
+        for (int id = RANS_SMALL_INLINE + 1; id < count; ++id) {
+            const SmallModel& m = r.tables[static_cast<size_t>(id)];
+            double cost = 0.0;
+            for (size_t k = 0; k < ALPH_SIZE; ++k) {
+                if (counts[k]) cost += double(counts[k]) * m.bits[k];
+            }
+            if (cost < best) {
+                best = cost;
+                pick = id;
+            }
+        }
+        return pick;
+    }
+
+    size_t stateBytes(State x) {
+        size_t k = 1;
+        while (k < sizeof(State) && (x >> (8 * k)) != 0) ++k;
+        return k;
+    }
+
+    template <class Sym>
+    void encodeSmall(const Sym* symbols, size_t n, int table, std::vector<uint8_t>& out) {
+        out.clear();
+        if (table < RANS_SMALL_AUTO || table >= MAX_TABLES) {
+            throw std::runtime_error("ransEncodeSmall: unknown table id");
+        }
+
+        Counts counts;
+        const bool needCounts = table == RANS_SMALL_INLINE || table == RANS_SMALL_AUTO;
+        if (needCounts && n != 0) counts = histogram(symbols, n);
+        if (table == RANS_SMALL_AUTO) table = n ? pickTable(counts, n) : RANS_SMALL_INLINE;
+
+        out.reserve(48 + (n + 1) * sizeof(uint32_t));
+        out.push_back(static_cast<uint8_t>(table));
+        writeVarint(out, n);
+        if (n == 0) return;
+
+        SmallModel inlineModel;
+        const SmallModel* m;
+        if (table == RANS_SMALL_INLINE) {
+            for (size_t k = 0; k + 1 < ALPH_SIZE; ++k) writeVarint(out, counts[k]);
+            inlineModel.model = Codec::normalize(counts);
+            Codec::buildEncTable(inlineModel.model, inlineModel.enc);
+            m = &inlineModel;
+        } else {
+            m = &tableModel(table, "ransEncodeSmall");
+        }
+
+        // Reverse order so the decoder runs forward.
+        CODEC_STAGE(Encode);
+        CODEC_COUNT(RansEncodeSymbols, n);
+        // The words go after a full-width state slot, which is cut down
+        // to k bytes once the state is known.
+        const size_t start = out.size();
+        const size_t base = start + sizeof(State);
+        out.resize(base + (n + 1) * sizeof(uint32_t));
+        uint8_t* p = out.data() + base;
+        State x = 1;
+        for (size_t i = n; i-- > 0; ) {
+            const unsigned s = static_cast<unsigned>(symbols[i]);
+            if (s >= ALPH_SIZE || m->model.freq[s] == 0) {
+                throw std::runtime_error("ransEncodeSmall: symbol not in the table's alphabet");
+            }
+            Codec::encodeSymbol(x, p, m->enc[s]);
+        }
+        out.resize(static_cast<size_t>(p - out.data()));
+        CODEC_COUNT(RansWordsOut, (out.size() - base) / sizeof(uint32_t));
+
+        Codec::reverseWords(out.data() + base, out.data() + out.size());
+
+        size_t k = stateBytes(x);
+        if (out.size() != base) k = std::max<size_t>(k, 5);
+        out.erase(out.begin() + static_cast<std::ptrdiff_t>(start + k),
+                  out.begin() + static_cast<std::ptrdiff_t>(base));
+        for (size_t i = 0; i < k; ++i) out[start + i] = static_cast<uint8_t>(x >> (8 * i));
+        CODEC_COUNT(RansBytesOut, out.size());
+    }
+
+    struct SmallHeader {
+        int table;
+        uint64_t n;
+        size_t offset; // first payload byte
+    };
+
+    SmallHeader readSmallHeader(const uint8_t* stream, size_t size) {
+        if (size < 2) {
+            throw std::runtime_error("ransDecodeSmall: stream too short");
+        }
+        SmallHeader h;
+        h.table  = stream[0];
+        h.offset = 1;
+        h.n      = readVarint(stream, size, h.offset);
+        return h;
+    }
+
+    template <class Out>
+    size_t decodeSmall(const uint8_t* stream, size_t size, Out* out, size_t capacity) {
+        SmallHeader h = readSmallHeader(stream, size);
+        if (h.n > capacity) {
+            throw std::runtime_error("ransDecodeSmall: output buffer too small");
+        }
+        if (h.n == 0) return 0;
+
+        Codec::Model inlineModel;
+        const Codec::Model* m;
+        if (h.table == RANS_SMALL_INLINE) {
+            Counts counts;
+            uint64_t sum = 0;
+            for (size_t k = 0; k + 1 < ALPH_SIZE; ++k) {
+                counts[k] = readVarint(stream, size, h.offset);
+                sum += counts[k];
+                if (sum > h.n) {
+                    throw std::runtime_error("ransDecodeSmall: bad symbol counts");
+                }
+            }
+            counts[ALPH_SIZE - 1] = h.n - sum;
+            inlineModel = Codec::normalize(counts);
+            m = &inlineModel;
+        } else {
+            m = &tableModel(h.table, "ransDecodeSmall").model;
+        }
+
+        const size_t tail = size - h.offset;
+        if (tail == 0) {
+            throw std::runtime_error("ransDecodeSmall: not enough bytes for final state");
+        }
+        const size_t k = tail <= sizeof(State) ? tail : 5 + (tail - 5) % 4;
+
+        // The branch-free renormalization loads the word just before the
+        // end even when it does not take it; a state of under four bytes
+        // with no words after it gets a padded copy so that load stays in
+        // bounds.
+        uint8_t pad[2 * sizeof(uint32_t)] = {};
+        const uint8_t* data = stream + h.offset;
+        if (tail < sizeof(uint32_t)) {
+            std::memcpy(pad + sizeof(uint32_t), data, tail);
+            data = pad + sizeof(uint32_t);
+        }
+
+        CODEC_STAGE(Decode);
+        CODEC_COUNT(RansDecodeSymbols, h.n);
+        State x = 0;
+        for (size_t i = 0; i < k; ++i) x |= static_cast<State>(data[i]) << (8 * i);
+        size_t idx = k;
+        for (uint64_t i = 0; i < h.n; ++i) {
+            out[i] = static_cast<Out>(Codec::decodeSymbol(x, data, idx, tail, *m));
+        }
+        CODEC_COUNT(RansWordsIn, (idx - k) / sizeof(uint32_t));
+        if (x != 1 || idx != tail) {
+            throw std::runtime_error("ransDecodeSmall: corrupt stream");
+        }
+        return static_cast<size_t>(h.n);
+    }
+} // namespace
+
+int ransRegisterSmallModel(const std::array<uint32_t, 4>& counts) {
+    Counts c;
+    for (size_t k = 0; k < ALPH_SIZE; ++k) c[k] = counts[k];
+    const SmallModel m = makeSmallModel(c);
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    const int id = r.count.load(std::memory_order_relaxed);
+    if (id >= MAX_TABLES) {
+        throw std::runtime_error("ransRegisterSmallModel: all 255 table ids are taken");
+    }
+    r.tables[static_cast<size_t>(id)] = m;
+    r.count.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+std::vector<uint8_t> ransEncodeSmall(const std::vector<int>& symbols, int table) {
+    std::vector<uint8_t> out;
+    encodeSmall(symbols.data(), symbols.size(), table, out);
+    return out;
+}
+
+std::vector<uint8_t> ransEncodeSmall(const std::vector<uint8_t>& symbols, int table) {
+    std::vector<uint8_t> out;
+    encodeSmall(symbols.data(), symbols.size(), table, out);
+    return out;
+}
+
+void ransEncodeSmall(const int* symbols, size_t n, int table, std::vector<uint8_t>& out) {
+    encodeSmall(symbols, n, table, out);
+}
+
+void ransEncodeSmall(const uint8_t* symbols, size_t n, int table, std::vector<uint8_t>& out) {
+    encodeSmall(symbols, n, table, out);
+}
+
+std::vector<int> ransDecodeSmall(const std::vector<uint8_t>& stream) {
+    std::vector<int> out(ransSmallDecodedSize(stream.data(), stream.size()));
+    ransDecodeSmall(stream.data(), stream.size(), out.data(), out.size());
+    return out;
+}
+
+size_t ransSmallDecodedSize(const uint8_t* stream, size_t size) {
+    return static_cast<size_t>(readSmallHeader(stream, size).n);
+}
+
+size_t ransDecodeSmall(const uint8_t* stream, size_t size, int* out, size_t capacity) {
+    return decodeSmall(stream, size, out, capacity);
+}
+
+size_t ransDecodeSmall(const uint8_t* stream, size_t size, uint8_t* out, size_t capacity) {
+    return decodeSmall(stream, size, out, capacity);
+}
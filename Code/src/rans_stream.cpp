@@ -0,0 +1,163 @@
+#include "rans_stream.hpp"
+#include "rans.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    constexpr int STREAM_LANES = 4;
+
+    void putU32LE(std::ostream& out, uint32_t v) {
+        char b[4];
+        for (int i = 0; i < 4; ++i) b[i] = static_cast<char>((v >> (8 * i)) & 0xFFu);
+        out.write(b, 4);
+    }
+
+    bool getU32LE(std::istream& in, uint32_t& v) {
+        unsigned char b[4];
+        in.read(reinterpret_cast<char*>(b), 4);
+        if (in.gcount() == 0) return false;
+        if (in.gcount() != 4) {
+            throw std::runtime_error("RansStreamDecoder: truncated block size");
+        }
+        v = 0;
+        for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(b[i]) << (8 * i);
+        return true;
+    }
+} // namespace
+
+// ==============================
+// Stream encoder
+// ==============================
+
+RansStreamEncoder::RansStreamEncoder(std::ostream& out, size_t blockSize)
+    : out_(out), blockSize_(blockSize)
+{
+    if (blockSize_ == 0) {
+        throw std::runtime_error("RansStreamEncoder: block size must be > 0");
+    }
+    block_.reserve(blockSize_);
+}
+
+void RansStreamEncoder::put(int symbol) {
+    writeImpl(&symbol, 1);
+}
+
+void RansStreamEncoder::write(const int* symbols, size_t n) {
+    writeImpl(symbols, n);
+}
+
+void RansStreamEncoder::write(const uint8_t* symbols, size_t n) {
+    writeImpl(symbols, n);
+}
+
+template <class Sym>
+void RansStreamEncoder::writeImpl(const Sym* symbols, size_t n) {
+    while (n > 0) {
+        const size_t take = std::min(n, blockSize_ - block_.size());
+        for (size_t i = 0; i < take; ++i) {
+            const unsigned s = static_cast<unsigned>(symbols[i]);
+            if (s > 3u) {
+                throw std::runtime_error("RansStreamEncoder: symbol out of range (0..3)");
+            }
+            block_.push_back(static_cast<uint8_t>(s));
+        }
+        symbols += take;
+        n -= take;
+        if (block_.size() == blockSize_) flushBlock();
+    }
+}
+
+void RansStreamEncoder::flushBlock() {
+    if (block_.empty()) return;
+    ransEncodeInterleaved(block_.data(), block_.size(), STREAM_LANES, packed_);
+    putU32LE(out_, static_cast<uint32_t>(packed_.size()));
+    out_.write(reinterpret_cast<const char*>(packed_.data()),
+               static_cast<std::streamsize>(packed_.size()));
+    block_.clear();
+}
+
+void RansStreamEncoder::finish() {
+    if (finished_) return;
+    flushBlock();
+    putU32LE(out_, 0);
+    out_.flush();
+    finished_ = true;
+}
+
+// ==============================
+// Stream decoder
+// ==============================
+
+RansStreamDecoder::RansStreamDecoder(std::istream& in)
+    : in_(in) {}
+
+bool RansStreamDecoder::readBlock() {
+    if (done_) return false;
+
+    uint32_t size = 0;
+    if (!getU32LE(in_, size)) {
+        throw std::runtime_error("RansStreamDecoder: missing end marker");
+    }
+    if (size == 0) {
+        done_ = true;
+        return false;
+    }
+
+    // Grow with the data that actually arrives rather than trusting size.
+    packed_.clear();
+    while (packed_.size() < size) {
+        const size_t at = packed_.size();
+        const size_t take = std::min<size_t>(size - at, RANS_STREAM_READ_CHUNK);
+        packed_.resize(at + take);
+        in_.read(reinterpret_cast<char*>(packed_.data() + at),
+                 static_cast<std::streamsize>(take));
+        if (static_cast<size_t>(in_.gcount()) != take) {
+            throw std::runtime_error("RansStreamDecoder: truncated block");
+        }
+    }
+    return true;
+}
+
+template <class Out>
+bool RansStreamDecoder::nextBlockImpl(std::vector<Out>& out) {
+    if (!readBlock()) return false;
+    out.resize(ransDecodedSize(packed_.data(), packed_.size()));
+    ransDecodeInterleaved(packed_.data(), packed_.size(), out.data(), out.size());
+    return true;
+}
+
+bool RansStreamDecoder::nextBlock(std::vector<int>& out) {
+    return nextBlockImpl(out);
+}
+
+bool RansStreamDecoder::nextBlock(std::vector<uint8_t>& out) {
+    return nextBlockImpl(out);
+}
+
+size_t RansStreamDecoder::read(int* dst, size_t n) {
+    return readImpl(dst, n);
+}
+
+size_t RansStreamDecoder::read(uint8_t* dst, size_t n) {
+    return readImpl(dst, n);
+}
+
+template <class Out>
+size_t RansStreamDecoder::readImpl(Out* dst, size_t n) {
+    size_t written = 0;
+    while (written < n) {
+        if (blockPos_ == block_.size()) {
+            blockPos_ = 0;
+            if (!nextBlock(block_)) {
+                block_.clear();
+                break;
+            }
+        }
+        const size_t take = std::min(n - written, block_.size() - blockPos_);
+        std::copy_n(block_.begin() + static_cast<std::ptrdiff_t>(blockPos_), take, dst + written);
+        blockPos_ += take;
+        written += take;
+    }
+    return written;
+}
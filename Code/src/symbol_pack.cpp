@@ -0,0 +1,38 @@
+#include "symbol_pack.hpp"
+#include "codec_trace.hpp"
+
+#include <stdexcept>
+
+std::vector<uint8_t> packSymbols2(const uint8_t* symbols, size_t n) {
+    CODEC_STAGE(Pack);
+    std::vector<uint8_t> packed(packedSize2(n));
+    const size_t full = n / 4;
+    for (size_t b = 0; b < full; ++b) {
+        const uint8_t* s = symbols + 4 * b;
+        if ((s[0] | s[1] | s[2] | s[3]) > 3u) {
+            throw std::runtime_error("packSymbols2: symbol out of range (0..3)");
+        }
+        packed[b] = static_cast<uint8_t>(s[0] | (s[1] << 2) | (s[2] << 4) | (s[3] << 6));
+    }
+    for (size_t i = 4 * full; i < n; ++i) {
+        if (symbols[i] > 3u) {
+            throw std::runtime_error("packSymbols2: symbol out of range (0..3)");
+        }
+        packed[full] = static_cast<uint8_t>(packed[full] | (symbols[i] << (2 * (i & 3))));
+    }
+    return packed;
+}
+
+void unpackSymbols2(const uint8_t* packed, size_t n, uint8_t* out) {
+    CODEC_STAGE(Pack);
+    const size_t full = n / 4;
+    for (size_t b = 0; b < full; ++b) {
+        const uint8_t v = packed[b];
+        out[4 * b + 0] = v & 3u;
+        out[4 * b + 1] = (v >> 2) & 3u;
+        out[4 * b + 2] = (v >> 4) & 3u;
+        out[4 * b + 3] = (v >> 6) & 3u;
+    }
+    const Packed2View view{packed};
+    for (size_t i = 4 * full; i < n; ++i) out[i] = view[i];
+}
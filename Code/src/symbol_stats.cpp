@@ -0,0 +1,363 @@
+#include "symbol_stats.hpp"
+#include "symbol_pack.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    constexpr int      LOG2_TABLE_BITS = 10;
+    constexpr uint64_t LOG2_TABLE_SIZE = uint64_t(1) << LOG2_TABLE_BITS;
+
+    // log2 of 0..1024, 0 at 0 so c * log2(c) vanishes for empty classes.
+    const double* log2Table() {
+        static const std::array<double, LOG2_TABLE_SIZE + 1> table = [] {
+            std::array<double, LOG2_TABLE_SIZE + 1> t{};
+            for (size_t i = 1; i < t.size(); ++i) t[i] = std::log2(static_cast<double>(i));
+            return t;
+        }();
+        return table.data();
+    }
+
+    constexpr uint64_t BYTE_ONES = 0x0101010101010101ull;
+
+    // Sum of the eight byte lanes of v, each at most 255.
+    uint64_t sumLanes(uint64_t v) {
+        v = (v & 0x00FF00FF00FF00FFull) + ((v >> 8) & 0x00FF00FF00FF00FFull);
+        return (v * 0x0001000100010001ull) >> 48;
+    }
+
+    // Each symbol is at most 3: count its low bit, its high bit and
+    // both, per byte lane, and recover the four classes from those.
+    // Lanes are summed every 255 words, before they can overflow.
+    SymbolHistogram histogramBytes(const uint8_t* symbols, size_t n) {
+        uint64_t bit0 = 0, bit1 = 0, both = 0, seen = 0;
+        size_t i = 0;
+        while (n - i >= 8) {
+            const size_t words = std::min<size_t>((n - i) / 8, 255);
+            uint64_t a0 = 0, a1 = 0, a3 = 0, any = 0;
+            for (size_t k = 0; k < words; ++k) {
+                uint64_t w;
+                std::memcpy(&w, symbols + i + 8 * k, sizeof(w));
+                const uint64_t lo = w & BYTE_ONES;
+                const uint64_t hi = (w >> 1) & BYTE_ONES;
+                a0 += lo;
+                a1 += hi;
+                a3 += lo & hi;
+                any |= w;
+            }
+            bit0 += sumLanes(a0);
+            bit1 += sumLanes(a1);
+            both += sumLanes(a3);
+            seen |= any;
+            i += 8 * words;
+        }
+        for (; i < n; ++i) {
+            const uint8_t s = symbols[i];
+            bit0 += s & 1u;
+            bit1 += (s >> 1) & 1u;
+            both += (s & (s >> 1)) & 1u;
+            seen |= s;
+        }
+        if (seen & ~(3 * BYTE_ONES)) {
+            throw std::runtime_error("symbolHistogram: symbol out of range (0..3)");
+        }
+        SymbolHistogram h;
+        h.counts[3] = both;
+        h.counts[1] = bit0 - both;
+        h.counts[2] = bit1 - both;
+        h.counts[0] = n - h.counts[1] - h.counts[2] - h.counts[3];
+        return h;
+    }
+
+    // Out-of-range symbols are masked while counting and reported once
+    // at the end; four interleaved tables break the store-to-load chain
+    // on runs of one symbol.
+    template <class Sym>
+    SymbolHistogram histogramWide(const Sym* symbols, size_t n, const char* fn) {
+        std::array<std::array<uint64_t, 4>, 4> t{};
+        uint64_t seen = 0;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const uint64_t s0 = static_cast<uint32_t>(symbols[i + 0]);
+            const uint64_t s1 = static_cast<uint32_t>(symbols[i + 1]);
+            const uint64_t s2 = static_cast<uint32_t>(symbols[i + 2]);
+            const uint64_t s3 = static_cast<uint32_t>(symbols[i + 3]);
+            t[0][s0 & 3]++;
+            t[1][s1 & 3]++;
+            t[2][s2 & 3]++;
+            t[3][s3 & 3]++;
+            seen |= s0 | s1 | s2 | s3;
+        }
+        for (; i < n; ++i) {
+            const uint64_t s = static_cast<uint32_t>(symbols[i]);
+            t[0][s & 3]++;
+            seen |= s;
+        }
+        if (seen > 3) throw std::runtime_error(std::string(fn) + ": symbol out of range (0..3)");
+        SymbolHistogram h;
+        for (size_t k = 0; k < 4; ++k) h.counts[k] = t[0][k] + t[1][k] + t[2][k] + t[3][k];
+        return h;
+    }
+
+    template <class Sym>
+    PairHistogram histogramPairs(const Sym* symbols, size_t n, unsigned prev) {
+        std::array<std::array<uint64_t, 16>, 4> t{};
+        uint64_t seen = prev;
+        uint64_t p = prev & 3u;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const uint64_t s0 = static_cast<uint32_t>(symbols[i + 0]);
+            const uint64_t s1 = static_cast<uint32_t>(symbols[i + 1]);
+            const uint64_t s2 = static_cast<uint32_t>(symbols[i + 2]);
+            const uint64_t s3 = static_cast<uint32_t>(symbols[i + 3]);
+            t[0][(p << 2 | s0) & 15]++;
+            t[1][(s0 << 2 | s1) & 15]++;
+            t[2][(s1 << 2 | s2) & 15]++;
+            t[3][(s2 << 2 | s3) & 15]++;
+            seen |= s0 | s1 | s2 | s3;
+            p = s3 & 3;
+        }
+        for (; i < n; ++i) {
+            const uint64_t s = static_cast<uint32_t>(symbols[i]);
+            t[0][(p << 2 | s) & 15]++;
+            seen |= s;
+            p = s & 3;
+        }
+        if (seen > 3) throw std::runtime_error("pairHistogram: symbol out of range (0..3)");
+        PairHistogram h;
+        for (size_t k = 0; k < 16; ++k) h.pairs[k] = t[0][k] + t[1][k] + t[2][k] + t[3][k];
+        return h;
+    }
+
+    size_t varintSize(uint64_t v) {
+        size_t len = 1;
+        while (v >= 0x80) { v >>= 7; ++len; }
+        return len;
+    }
+
+    // Fixed stream overheads, from the formats in rans.hpp and cabac.hpp.
+    constexpr double RANS0_HEADER_BYTES = 16; // N, four u16 freqs, 32-bit state
+    constexpr double RANS1_STATE_BYTES  = 10; // 64-bit state, word padding
+    constexpr double CABAC_HEADER_BYTES = 8;  // N, type, mode, flush
+
+    // CABAC's most skewed state gives the LPS about 1.9%, so a context
+    // never costs less than -log2(1 - 0.01875) bits per bin; away from
+    // that floor the state machine runs about 2.5% above the entropy.
+    constexpr double CABAC_MIN_LPS    = 0.01875;
+    constexpr double CABAC_EFFICIENCY = 1.025;
+
+    // Bits for one CABAC context that sees `ones` ones in n bins, scaled
+    // by `scale` sampled-to-real symbols.
+    double cabacContextBits(uint64_t ones, uint64_t n, double scale) {
+        if (n == 0) return 0.0;
+        const uint64_t lps = std::min(ones, n - ones);
+        double bits;
+        if (static_cast<double>(lps) >= CABAC_MIN_LPS * static_cast<double>(n)) {
+            const uint64_t c[2] = {ones, n - ones};
+            bits = entropyBits(c, 2);
+        } else {
+            bits = static_cast<double>(lps) * -std::log2(CABAC_MIN_LPS) +
+                   static_cast<double>(n - lps) * -std::log2(1.0 - CABAC_MIN_LPS);
+        }
+        // Plus about half a bit per doubling to learn the probability.
+        const double learn = 0.5 * std::log2(scale * static_cast<double>(n) + 1.0);
+        return CABAC_EFFICIENCY * bits * scale + learn;
+    }
+
+    // Size of the compact order-1 table (see rans_context.cpp) for one
+    // context with these counts and `total` symbols.
+    double rans1TableBytes(const uint64_t* c, uint64_t total) {
+        size_t used = 0;
+        for (size_t k = 0; k < 4; ++k) used += c[k] != 0;
+        double bytes = 1 + static_cast<double>(used); // K, symbol gaps
+        size_t written = 0;
+        for (size_t k = 0; k < 4 && written + 1 < used; ++k) {
+            if (c[k] == 0) continue;
+            bytes += static_cast<double>(varintSize((c[k] << 16) / total));
+            ++written;
+        }
+        return bytes;
+    }
+
+    CodecEstimate estimateFromPairs(const PairHistogram& h, size_t n, size_t sampled) {
+        CodecEstimate e;
+        e.sampled = sampled;
+        e.bytes[static_cast<size_t>(CodecChoice::Raw)] = static_cast<double>(packedSize2(n));
+        if (n == 0) return e;
+
+        const double scale = static_cast<double>(n) / static_cast<double>(sampled);
+        const SymbolHistogram h0 = h.symbols();
+        e.entropy0 = symbolEntropy(h0);
+        e.entropy1 = conditionalEntropy(h);
+
+        e.bytes[static_cast<size_t>(CodecChoice::RansOrder0)] =
+            RANS0_HEADER_BYTES + e.entropy0 * static_cast<double>(n) / 8.0;
+
+        double order1 = static_cast<double>(varintSize(n)) + 2; // N, order, mask
+        double cabacBits = 0.0;
+        for (size_t p = 0; p < 4; ++p) {
+            const uint64_t* c = h.pairs.data() + 4 * p;
+            const uint64_t t = c[0] + c[1] + c[2] + c[3];
+            if (t == 0) continue;
+            order1 += rans1TableBytes(c, t);
+            // Good binarization: bin k is coded for symbols >= k and is
+            // 1 for symbols > k; the terminating 0 of symbol 3 is kept.
+            uint64_t atLeast = t;
+            for (size_t k = 0; k < 4; ++k) {
+                const uint64_t above = atLeast - c[k];
+                cabacBits += cabacContextBits(above, atLeast, scale);
+                atLeast = above;
+            }
+        }
+        order1 += RANS1_STATE_BYTES + e.entropy1 * static_cast<double>(n) / 8.0;
+        e.bytes[static_cast<size_t>(CodecChoice::RansOrder1)] = order1;
+        e.bytes[static_cast<size_t>(CodecChoice::Cabac)] = CABAC_HEADER_BYTES + cabacBits / 8.0;
+
+        for (size_t c = 0; c < CODEC_CHOICE_COUNT; ++c) {
+            if (e.bytes[c] < e.size(e.best)) e.best = static_cast<CodecChoice>(c);
+        }
+        return e;
+    }
+
+    constexpr size_t SAMPLE_RUNS = 16;
+
+    template <class Sym>
+    CodecEstimate estimate(const Sym* symbols, size_t n, size_t sample) {
+        sample = std::max(sample, SAMPLE_RUNS);
+        if (n <= sample) return estimateFromPairs(histogramPairs(symbols, n, 0), n, n);
+
+        // Runs keep their pairs intact: each starts from the symbol
+        // before it.
+        const size_t runLen = sample / SAMPLE_RUNS;
+        const size_t stride = n / SAMPLE_RUNS;
+        PairHistogram h;
+        for (size_t r = 0; r < SAMPLE_RUNS; ++r) {
+            const size_t start = r * stride;
+            const unsigned prev = start ? static_cast<unsigned>(symbols[start - 1]) : 0u;
+            const PairHistogram part = histogramPairs(symbols + start, runLen, prev);
+            for (size_t k = 0; k < 16; ++k) h.pairs[k] += part.pairs[k];
+        }
+        return estimateFromPairs(h, n, runLen * SAMPLE_RUNS);
+    }
+} // namespace
+
+SymbolHistogram PairHistogram::symbols() const {
+    SymbolHistogram h;
+    for (size_t k = 0; k < 16; ++k) h.counts[k & 3] += pairs[k];
+    return h;
+}
+
+SymbolHistogram symbolHistogram(const uint8_t* symbols, size_t n) {
+    return histogramBytes(symbols, n);
+}
+
+SymbolHistogram symbolHistogram(const int* symbols, size_t n) {
+    return histogramWide(symbols, n, "symbolHistogram");
+}
+
+PairHistogram pairHistogram(const uint8_t* symbols, size_t n, unsigned prev) {
+    return histogramPairs(symbols, n, prev);
+}
+
+PairHistogram pairHistogram(const int* symbols, size_t n, unsigned prev) {
+    return histogramPairs(symbols, n, prev);
+}
+
+SymbolHistogram symbolHistogram(const uint8_t* symbols, size_t n, ThreadPool& pool) {
+    constexpr size_t CHUNK = size_t(1) << 20;
+    const size_t chunks = (n + CHUNK - 1) / CHUNK;
+    if (chunks <= 1 || pool.size() <= 1) return histogramBytes(symbols, n);
+
+    std::vector<SymbolHistogram> parts(chunks);
+    pool.parallelFor(chunks, [&](size_t c) {
+        const size_t begin = c * CHUNK;
+        parts[c] = histogramBytes(symbols + begin, std::min(CHUNK, n - begin));
+    });
+    SymbolHistogram h;
+    for (const SymbolHistogram& p : parts) {
+        for (size_t k = 0; k < 4; ++k) h.counts[k] += p.counts[k];
+    }
+    return h;
+}
+
+double fastLog2(uint64_t x) {
+    const double* t = log2Table();
+    if (x <= LOG2_TABLE_SIZE) return t[x];
+    int shift = 0;
+    for (uint64_t v = x >> LOG2_TABLE_BITS; v; v >>= 1) ++shift;
+    const uint64_t hi = x >> shift; // in [512, 1024)
+    const double frac = static_cast<double>(x & ((uint64_t(1) << shift) - 1)) /
+                        static_cast<double>(uint64_t(1) << shift);
+    return shift + t[hi] + frac * (t[hi + 1] - t[hi]);
+}
+
+double entropyBits(const uint64_t* counts, size_t k) {
+    uint64_t total = 0;
+    double sum = 0.0;
+    for (size_t i = 0; i < k; ++i) {
+        total += counts[i];
+        sum += static_cast<double>(counts[i]) * fastLog2(counts[i]);
+    }
+    if (total == 0) return 0.0;
+    return std::max(0.0, static_cast<double>(total) * fastLog2(total) - sum);
+}
+
+double symbolEntropy(const SymbolHistogram& h) {
+    const uint64_t total = h.total();
+    if (total == 0) return 0.0;
+    return entropyBits(h.counts.data(), 4) / static_cast<double>(total);
+}
+
+double conditionalEntropy(const PairHistogram& h) {
+    uint64_t total = 0;
+    double bits = 0.0;
+    for (size_t p = 0; p < 4; ++p) {
+        const uint64_t* c = h.pairs.data() + 4 * p;
+        total += c[0] + c[1] + c[2] + c[3];
+        bits += entropyBits(c, 4);
+    }
+    return total ? bits / static_cast<double>(total) : 0.0;
+}
+
+double binaryEntropy(uint64_t ones, uint64_t n) {
+    if (n == 0 || ones > n) return 0.0;
+    const uint64_t c[2] = {ones, n - ones};
+    return entropyBits(c, 2) / static_cast<double>(n);
+}
+
+const char* codecChoiceName(CodecChoice c) {
+    switch (c) {
+        case CodecChoice::RansOrder0: return "rans_o0";
+        case CodecChoice::RansOrder1: return "rans_o1";
+        case CodecChoice::Cabac:      return "cabac";
+        case CodecChoice::Raw:        return "raw";
+        case CodecChoice::Count:      break;
+    }
+    return "?";
+}
+
+CodecEstimate estimateCodecs(const uint8_t* symbols, size_t n, size_t sample) {
+    return estimate(symbols, n, sample);
+}
+
+CodecEstimate estimateCodecs(const int* symbols, size_t n, size_t sample) {
+    return estimate(symbols, n, sample);
+}
+
+std::vector<CodecEstimate> estimateBlocks(const uint8_t* symbols, size_t n,
+                                          size_t blockSize, ThreadPool& pool,
+                                          size_t sample)
+{
+    if (blockSize == 0) throw std::runtime_error("estimateBlocks: blockSize must be > 0");
+    const size_t blocks = (n + blockSize - 1) / blockSize;
+    std::vector<CodecEstimate> out(blocks);
+    pool.parallelFor(blocks, [&](size_t b) {
+        const size_t begin = b * blockSize;
+        out[b] = estimate(symbols + begin, std::min(blockSize, n - begin), sample);
+    });
+    return out;
+}
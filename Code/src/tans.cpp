@@ -0,0 +1,225 @@
+#include "tans.hpp"
+#include "bitstream.hpp"
+#include "byte_io.hpp"
+#include "rans_model.hpp"
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    constexpr int      TABLE_LOG  = static_cast<int>(RANS_SCALE_BITS);
+    constexpr uint32_t TABLE_SIZE = RANS_TOTFREQ;
+    constexpr int      ALPH_SIZE  = RANS_ALPH_SIZE;
+
+    // Symbols per writeBits/peekBits batch: 4 x TABLE_LOG bits <= 48.
+    constexpr int BATCH = 4;
+
+    int highBit(uint32_t v) {
+        int b = 0;
+        while (v >>= 1) b++;
+        return b;
+    }
+
+    // Scatter each symbol's freq[s] slots over the table with an odd step
+    // so equal symbols are spread out; the step visits every slot once.
+    std::array<uint8_t, TABLE_SIZE> spreadSymbols(const RansModel& m) {
+        std::array<uint8_t, TABLE_SIZE> table{};
+        const uint32_t step = (TABLE_SIZE >> 1) + (TABLE_SIZE >> 3) + 3;
+        uint32_t pos = 0;
+        for (int s = 0; s < ALPH_SIZE; ++s) {
+            for (uint32_t i = 0; i < m.freq[s]; ++i) {
+                table[pos] = static_cast<uint8_t>(s);
+                pos = (pos + step) & (TABLE_SIZE - 1);
+            }
+        }
+        return table;
+    }
+
+    // Encoder: state X lives in [TABLE_SIZE, 2 * TABLE_SIZE). Symbol s
+    // emits nb = (X + deltaNbBits) >> 16 low bits of X, then moves to
+    // nextState[(X >> nb) + deltaFindState].
+    struct EncSymbol {
+        uint32_t deltaNbBits;
+        int32_t  deltaFindState;
+    };
+
+    struct EncTable {
+        std::array<uint16_t, TABLE_SIZE> nextState;
+        std::array<EncSymbol, ALPH_SIZE> sym;
+    };
+
+    void buildEncTable(const RansModel& m, EncTable& t) {
+        const auto spread = spreadSymbols(m);
+        std::array<uint32_t, ALPH_SIZE> next{};
+        for (int s = 0; s < ALPH_SIZE; ++s) next[s] = m.cum[s];
+        for (uint32_t u = 0; u < TABLE_SIZE; ++u) {
+            t.nextState[next[spread[u]]++] = static_cast<uint16_t>(TABLE_SIZE + u);
+        }
+
+        for (int s = 0; s < ALPH_SIZE; ++s) {
+            const uint32_t f = m.freq[s];
+            const uint32_t maxBitsOut = TABLE_LOG - (f > 1 ? highBit(f - 1) : 0);
+            const uint32_t minStatePlus = (f > 1 ? f : 1u) << maxBitsOut;
+            t.sym[s].deltaNbBits    = (maxBitsOut << 16) - minStatePlus;
+            t.sym[s].deltaFindState = static_cast<int32_t>(m.cum[s]) - static_cast<int32_t>(f);
+        }
+    }
+
+    // Decoder: state in [0, TABLE_SIZE); new state = base + next nbBits.
+    struct DecEntry {
+        uint16_t newState;
+        uint8_t  sym;
+        uint8_t  nbBits;
+    };
+
+    using DecTable = std::array<DecEntry, TABLE_SIZE>;
+
+    void buildDecTable(const RansModel& m, DecTable& t) {
+        const auto spread = spreadSymbols(m);
+        std::array<uint32_t, ALPH_SIZE> next{};
+        for (int s = 0; s < ALPH_SIZE; ++s) next[s] = m.freq[s];
+        for (uint32_t u = 0; u < TABLE_SIZE; ++u) {
+            const uint8_t s = spread[u];
+            const uint32_t x = next[s]++; // in [freq, 2 * freq)
+            const int nb = TABLE_LOG - highBit(x);
+            t[u].sym      = s;
+            t[u].nbBits   = static_cast<uint8_t>(nb);
+            t[u].newState = static_cast<uint16_t>((x << nb) - TABLE_SIZE);
+        }
+    }
+} // namespace
+
+// ==============================
+// tANS ENCODER
+// ==============================
+
+namespace {
+    template <class Sym>
+    std::vector<uint8_t> encodeImpl(const Sym* symbols, size_t n, const RansModel& m) {
+        const uint32_t N = static_cast<uint32_t>(n);
+        EncTable t;
+        buildEncTable(m, t);
+
+        // Symbols are coded in reverse, so the bits come out in the opposite
+        // order to the one the decoder reads them in; record them per symbol
+        // as (bits << 4) | nb and write them out forward.
+        std::vector<uint16_t> emitted(N);
+        uint32_t x = TABLE_SIZE;
+        for (size_t i = N; i-- > 0; ) {
+            const EncSymbol& e = t.sym[symbols[i]];
+            const uint32_t nb = (x + e.deltaNbBits) >> 16;
+            emitted[i] = static_cast<uint16_t>(((x & ((1u << nb) - 1)) << 4) | nb);
+            x = t.nextState[static_cast<size_t>(static_cast<int32_t>(x >> nb) + e.deltaFindState)];
+        }
+
+        std::vector<uint8_t> out;
+        out.reserve(16 + n / 2);
+        writeU32LE(out, N);
+        ransWriteModel(out, m);
+
+        BitWriter bw;
+        bw.writeBits(x - TABLE_SIZE, TABLE_LOG);
+        size_t i = 0;
+        for (; i + BATCH <= N; i += BATCH) {
+            uint64_t v = 0;
+            int nb = 0;
+            for (int j = 0; j < BATCH; ++j) {
+                const uint16_t r = emitted[i + j];
+                v |= static_cast<uint64_t>(r >> 4) << nb;
+                nb += r & 0xF;
+            }
+            bw.writeBits(v, nb);
+        }
+        for (; i < N; ++i) {
+            bw.writeBits(emitted[i] >> 4, emitted[i] & 0xF);
+        }
+
+        const std::vector<uint8_t> bits = bw.flush();
+        out.insert(out.end(), bits.begin(), bits.end());
+        return out;
+    }
+} // namespace
+
+std::vector<uint8_t> tansEncode(const std::vector<int>& symbols) {
+    return tansEncode(symbols.data(), symbols.size());
+}
+
+std::vector<uint8_t> tansEncode(const std::vector<uint8_t>& symbols) {
+    return tansEncode(symbols.data(), symbols.size());
+}
+
+std::vector<uint8_t> tansEncode(const int* symbols, size_t n) {
+    if (n == 0) return {};
+    return encodeImpl(symbols, n, ransBuildModel(symbols, n));
+}
+
+std::vector<uint8_t> tansEncode(const uint8_t* symbols, size_t n) {
+    if (n == 0) return {};
+    return encodeImpl(symbols, n, ransBuildModel(symbols, n));
+}
+
+// ==============================
+// tANS DECODER
+// ==============================
+
+namespace {
+    template <class Out>
+    size_t decodeImpl(const uint8_t* stream, size_t size, Out* out, size_t capacity) {
+        if (size < 12) {
+            throw std::runtime_error("tansDecode: stream too short");
+        }
+
+        size_t offset = 0;
+        const uint32_t N = readU32LE(stream, size, offset);
+        if (N > capacity) {
+            throw std::runtime_error("tansDecode: output buffer too small");
+        }
+        RansModel m = ransReadModel(stream, size, offset);
+
+        DecTable t;
+        buildDecTable(m, t);
+
+        BitReader br(stream + offset, size - offset);
+        uint32_t state = static_cast<uint32_t>(br.readBits(TABLE_LOG));
+
+        size_t i = 0;
+        for (; i + BATCH <= N; i += BATCH) {
+            uint64_t w = br.peekBits(BATCH * TABLE_LOG);
+            int used = 0;
+            for (int j = 0; j < BATCH; ++j) {
+                const DecEntry d = t[state];
+                out[i + j] = d.sym;
+                state = d.newState + static_cast<uint32_t>(w & ((1u << d.nbBits) - 1));
+                w >>= d.nbBits;
+                used += d.nbBits;
+            }
+            br.skipBits(used);
+        }
+        for (; i < N; ++i) {
+            const DecEntry d = t[state];
+            out[i] = d.sym;
+            state = d.newState + static_cast<uint32_t>(br.readBits(d.nbBits));
+        }
+        return N;
+    }
+} // namespace
+
+std::vector<int> tansDecode(const std::vector<uint8_t>& stream) {
+    if (stream.size() < 12) {
+        throw std::runtime_error("tansDecode: stream too short");
+    }
+    size_t offset = 0;
+    std::vector<int> out(readU32LE(stream, offset));
+    tansDecode(stream.data(), stream.size(), out.data(), out.size());
+    return out;
+}
+
+size_t tansDecode(const uint8_t* stream, size_t size, int* out, size_t capacity) {
+    return decodeImpl(stream, size, out, capacity);
+}
+
+size_t tansDecode(const uint8_t* stream, size_t size, uint8_t* out, size_t capacity) {
+    return decodeImpl(stream, size, out, capacity);
+}
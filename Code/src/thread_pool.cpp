@@ -0,0 +1,93 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : workers_) t.join();
+}
+
+void ThreadPool::enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push(std::move(job));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+            if (stop_ && jobs_.empty()) return;
+            job = std::move(jobs_.front());
+            jobs_.pop();
+        }
+        job();
+    }
+}
+
+void ThreadPool::parallelFor(size_t n, const std::function<void(size_t)>& fn,
+                             unsigned maxRunners)
+{
+    if (n == 0) return;
+
+    // One runner per worker pulls indices from a shared counter, so uneven
+    // items balance themselves.
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto runner = [&]() {
+        for (size_t i; !failed && (i = next.fetch_add(1)) < n; ) {
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    size_t runners = std::min<size_t>(n, workers_.size());
+    if (maxRunners != 0) runners = std::min<size_t>(runners, maxRunners);
+    std::vector<std::future<void>> done;
+    done.reserve(runners);
+    for (size_t r = 0; r < runners; ++r) done.push_back(submit(runner));
+    for (auto& f : done) f.wait();
+
+    if (error) std::rethrow_exception(error);
+}
+
+ThreadPool& sharedThreadPool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void parallelForThreads(size_t n, unsigned threads,
+                        const std::function<void(size_t)>& fn)
+{
+    if (threads == 1 || n <= 1) {
+        for (size_t i = 0; i < n; ++i) fn(i);
+        return;
+    }
+    sharedThreadPool().parallelFor(n, fn, threads);
+}
@@ -0,0 +1,120 @@
+// Roundtrips for the runtime binarizations, on their own and driving
+// the CABAC symbol coder through registry ids, including codes longer
+// than the decode table's peek (the decodeLong path).
+
+#include "binarization.hpp"
+#include "cabac.hpp"
+
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    void check(bool ok, const std::string& what) {
+        if (!ok) {
+            std::printf("FAIL: %s\n", what.c_str());
+            ++failures;
+        }
+    }
+
+    bool throws(const std::function<void()>& fn) {
+        try {
+            fn();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    }
+
+    // Every symbol once, then a skewed random sequence.
+    std::vector<int> sampleSymbols(size_t alphabet) {
+        std::vector<int> symbols;
+        for (size_t s = 0; s < alphabet; ++s) symbols.push_back(static_cast<int>(s));
+        std::mt19937 rng(7);
+        std::geometric_distribution<int> geo(0.3);
+        for (int i = 0; i < 5000; ++i) {
+            symbols.push_back(static_cast<int>(static_cast<size_t>(geo(rng)) % alphabet));
+        }
+        return symbols;
+    }
+
+    void roundtrip(const std::string& name, const Binarization& b, bool isLong) {
+        check((b.maxLength() > BIN_MAX_PEEK) == isLong, name + ": codeword lengths");
+
+        const std::vector<int> symbols = sampleSymbols(b.alphabetSize());
+        const BinString bins = b.binarize(symbols);
+        check(b.debinarize(bins) == symbols, name + ": debinarize");
+
+        std::vector<int> out(symbols.size());
+        const size_t got = b.debinarize(bins, out.data(), out.size());
+        check(got == symbols.size() && out == symbols, name + ": debinarize into a buffer");
+
+        for (size_t s = 0; s < b.alphabetSize(); ++s) {
+            const BinCode c = b.code(static_cast<unsigned>(s));
+            const BinDecodeEntry e = b.match(c.code, c.len);
+            check(e.len == c.len && e.symbol == s, name + ": match " + std::to_string(s));
+        }
+
+        const int id = registerBinarization(b);
+        using Mode = CabacContextMode;
+        for (Mode mode : {Mode::Single, Mode::BinIndex, Mode::BinIndexPrevSymbol}) {
+            std::vector<uint8_t> stream;
+            cabacEncodeSymbols(symbols.data(), symbols.size(), id, mode, stream);
+            check(cabacDecodeSymbols(stream) == symbols, name + ": CABAC roundtrip");
+        }
+    }
+} // namespace
+
+int main() {
+    roundtrip("fixedLength(3)", Binarization::fixedLength(3), false);
+    roundtrip("fixedLength(16)", Binarization::fixedLength(16), true);
+    roundtrip("truncatedUnary(6)", Binarization::truncatedUnary(6), false);
+    roundtrip("truncatedUnary(24)", Binarization::truncatedUnary(24), true);
+    roundtrip("expGolomb(0)", Binarization::expGolomb(0, 200), true);
+    roundtrip("expGolomb(2)", Binarization::expGolomb(2, 40), false);
+    roundtrip("truncatedRice(1)", Binarization::truncatedRice(1, 9), false);
+    roundtrip("truncatedRice(2)", Binarization::truncatedRice(2, 60), true);
+
+    // uint8_t symbols through a registered code.
+    {
+        const int id = registerBinarization(Binarization::fixedLength(3));
+        const std::vector<uint8_t> symbols = {0, 7, 3, 3, 5, 1, 6, 2, 4};
+        std::vector<uint8_t> stream;
+        cabacEncodeSymbols(symbols.data(), symbols.size(), id,
+                           CabacContextMode::BinIndex, stream);
+        std::vector<uint8_t> out(symbols.size());
+        const size_t got = cabacDecodeSymbols(stream.data(), stream.size(),
+                                              out.data(), out.size());
+        check(got == symbols.size() && out == symbols, "fixedLength(3): uint8_t CABAC roundtrip");
+    }
+
+    // A long prefix with no codeword behind it: Exp-Golomb over 200
+    // symbols leaves most 15-bin windows unassigned.
+    {
+        const Binarization b = Binarization::expGolomb(0, 200);
+        BinString bins;
+        bins.append(0x7FFFu, 15);
+        check(throws([&] { b.debinarize(bins); }), "expGolomb: invalid long codeword");
+        check(b.match(0x7FFFu, 15).len == 0, "expGolomb: match on a non-codeword");
+    }
+
+    // Unknown binarizations are rejected, never decoded as Bad.
+    {
+        const std::vector<int> symbols = {0, 1, 2, 3};
+        std::vector<uint8_t> stream = cabacEncodeSymbols(symbols);
+        stream[4] = 250;
+        check(throws([&] { cabacDecodeSymbols(stream); }), "unknown id decoded");
+        const auto bogus = static_cast<BinarizationType>(5);
+        check(throws([&] { binCode(0, bogus); }),
+              "unknown BinarizationType accepted by binCode");
+        check(throws([&] { cabacEncodeSymbols(symbols, bogus); }),
+              "unknown BinarizationType accepted by cabacEncodeSymbols");
+    }
+
+    return failures == 0 ? 0 : 1;
+}